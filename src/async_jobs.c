@@ -0,0 +1,577 @@
+#include "async_jobs.h"
+#include "encryption.h"
+#include "decryption.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/stat.h>
+
+#define ASYNC_CHUNK_SIZE (256 * 1024)
+#define ASYNC_INITIAL_BUCKETS 64   // Power of two; doubles as jobs pile up
+
+typedef struct completion_node {
+    fe_completion completion;
+    struct completion_node* next;
+} completion_node;
+
+typedef struct fe_job {
+    fe_job_id id;
+    fe_job_op op;
+    int key;
+    void* user_data;
+
+    // File jobs own copies of their paths; buffer jobs borrow the caller's memory
+    char* input_filename;
+    char* output_filename;
+    uint8_t* data;
+    size_t length;
+
+    _Atomic uint64_t bytes_done;
+    _Atomic uint64_t bytes_total;
+    atomic_bool cancelled;
+    bool running;
+
+    // Allocated at submit so that completing a job can never fail
+    completion_node* done;
+
+    // Pending jobs, in submission order
+    struct fe_job* queue_prev;
+    struct fe_job* queue_next;
+
+    // Chain in the id table of jobs that have not completed yet
+    struct fe_job* live_next;
+} fe_job;
+
+struct fe_async {
+    pthread_mutex_t lock;
+    pthread_cond_t work_ready;
+    pthread_t* workers;
+    unsigned int worker_count;
+
+    fe_job* queue_head;
+    fe_job* queue_tail;
+
+    // Jobs that have not completed yet, keyed by id for cancel/progress
+    fe_job** live_buckets;
+    size_t live_bucket_count;
+    size_t live_count;
+
+    completion_node* done_head;
+    completion_node* done_tail;
+
+    fe_job_id next_id;
+    bool shutting_down;
+    int event_fd;
+};
+
+static void free_job(fe_job* job) {
+    free(job->done);
+    free(job->input_filename);
+    free(job->output_filename);
+    free(job);
+}
+
+static void queue_remove(fe_async* ctx, fe_job* job) {
+    if (job->queue_prev) {
+        job->queue_prev->queue_next = job->queue_next;
+    } else {
+        ctx->queue_head = job->queue_next;
+    }
+    if (job->queue_next) {
+        job->queue_next->queue_prev = job->queue_prev;
+    } else {
+        ctx->queue_tail = job->queue_prev;
+    }
+    job->queue_prev = job->queue_next = NULL;
+}
+
+// Ids are handed out sequentially, so the low bits spread jobs evenly
+static fe_job** live_bucket(fe_async* ctx, fe_job_id id) {
+    return &ctx->live_buckets[id & (ctx->live_bucket_count - 1)];
+}
+
+static void live_insert(fe_async* ctx, fe_job* job) {
+    // Keep chains short; if growing fails the table still works, just slower
+    if (ctx->live_count >= ctx->live_bucket_count) {
+        size_t count = ctx->live_bucket_count * 2;
+        fe_job** buckets = calloc(count, sizeof(*buckets));
+        if (buckets) {
+            for (size_t i = 0; i < ctx->live_bucket_count; i++) {
+                fe_job* next;
+                for (fe_job* moved = ctx->live_buckets[i]; moved; moved = next) {
+                    next = moved->live_next;
+                    moved->live_next = buckets[moved->id & (count - 1)];
+                    buckets[moved->id & (count - 1)] = moved;
+                }
+            }
+            free(ctx->live_buckets);
+            ctx->live_buckets = buckets;
+            ctx->live_bucket_count = count;
+        }
+    }
+
+    fe_job** bucket = live_bucket(ctx, job->id);
+    job->live_next = *bucket;
+    *bucket = job;
+    ctx->live_count++;
+}
+
+static void live_remove(fe_async* ctx, fe_job* job) {
+    for (fe_job** link = live_bucket(ctx, job->id); *link; link = &(*link)->live_next) {
+        if (*link == job) {
+            *link = job->live_next;
+            ctx->live_count--;
+            return;
+        }
+    }
+}
+
+static fe_job* find_live(fe_async* ctx, fe_job_id id) {
+    for (fe_job* job = *live_bucket(ctx, id); job; job = job->live_next) {
+        if (job->id == id) {
+            return job;
+        }
+    }
+    return NULL;
+}
+
+// Called with ctx->lock held; consumes the job
+static void complete_job(fe_async* ctx, fe_job* job, fe_job_status status, int error) {
+    live_remove(ctx, job);
+
+    completion_node* node = job->done;
+    job->done = NULL;
+
+    node->completion.id = job->id;
+    node->completion.status = status;
+    node->completion.error = error;
+    node->completion.bytes_processed = atomic_load_explicit(&job->bytes_done, memory_order_relaxed);
+    node->completion.user_data = job->user_data;
+    node->next = NULL;
+
+    if (ctx->done_tail) {
+        ctx->done_tail->next = node;
+    } else {
+        ctx->done_head = node;
+    }
+    ctx->done_tail = node;
+
+    // Written under the lock so a concurrent drain in fe_poll_completions
+    // can never swallow the signal for a completion it did not return
+    uint64_t one = 1;
+    ssize_t ignored = write(ctx->event_fd, &one, sizeof(one));
+    (void)ignored;
+
+    free_job(job);
+}
+
+static void transform_chunk(fe_job_op op, uint8_t* data, size_t length, int key) {
+    if (op == FE_JOB_DECRYPT) {
+        decrypt_buffer(data, length, key);
+    } else {
+        encrypt_buffer(data, length, key);
+    }
+}
+
+static int write_all(int fd, const uint8_t* data, size_t length) {
+    while (length > 0) {
+        ssize_t n = write(fd, data, length);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        data += n;
+        length -= (size_t)n;
+    }
+    return 0;
+}
+
+static fe_job_status run_buffer_job(fe_job* job, int* error) {
+    *error = 0;
+    size_t offset = 0;
+
+    // Chunked so that cancellation and progress stay responsive on big buffers
+    while (offset < job->length) {
+        if (atomic_load_explicit(&job->cancelled, memory_order_relaxed)) {
+            return FE_JOB_CANCELLED;
+        }
+
+        size_t n = job->length - offset;
+        if (n > ASYNC_CHUNK_SIZE) {
+            n = ASYNC_CHUNK_SIZE;
+        }
+
+        transform_chunk(job->op, job->data + offset, n, job->key);
+        offset += n;
+        atomic_store_explicit(&job->bytes_done, offset, memory_order_relaxed);
+    }
+
+    return FE_JOB_OK;
+}
+
+static fe_job_status run_file_job(fe_job* job, int* error) {
+    *error = 0;
+
+    int input_fd = open(job->input_filename, O_RDONLY | O_CLOEXEC);
+    if (input_fd < 0) {
+        *error = errno;
+        return FE_JOB_FAILED;
+    }
+
+    struct stat input_stat;
+    if (fstat(input_fd, &input_stat) == 0) {
+        atomic_store_explicit(&job->bytes_total, (uint64_t)input_stat.st_size, memory_order_relaxed);
+    }
+
+    int output_fd = open(job->output_filename, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (output_fd < 0) {
+        *error = errno;
+        close(input_fd);
+        return FE_JOB_FAILED;
+    }
+
+    uint8_t* buffer = malloc(ASYNC_CHUNK_SIZE);
+    fe_job_status status = FE_JOB_OK;
+    uint64_t done = 0;
+
+    if (!buffer) {
+        *error = ENOMEM;
+        status = FE_JOB_FAILED;
+    }
+
+    while (status == FE_JOB_OK) {
+        if (atomic_load_explicit(&job->cancelled, memory_order_relaxed)) {
+            status = FE_JOB_CANCELLED;
+            break;
+        }
+
+        ssize_t n = read(input_fd, buffer, ASYNC_CHUNK_SIZE);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            *error = errno;
+            status = FE_JOB_FAILED;
+            break;
+        }
+        if (n == 0) {
+            break;
+        }
+
+        transform_chunk(job->op, buffer, (size_t)n, job->key);
+
+        if (write_all(output_fd, buffer, (size_t)n) != 0) {
+            *error = errno;
+            status = FE_JOB_FAILED;
+            break;
+        }
+
+        done += (uint64_t)n;
+        atomic_store_explicit(&job->bytes_done, done, memory_order_relaxed);
+    }
+
+    free(buffer);
+    close(input_fd);
+    if (close(output_fd) != 0 && status == FE_JOB_OK) {
+        *error = errno;
+        status = FE_JOB_FAILED;
+    }
+
+    // Do not leave truncated outputs behind
+    if (status != FE_JOB_OK) {
+        unlink(job->output_filename);
+    }
+
+    return status;
+}
+
+static void* worker_main(void* arg) {
+    fe_async* ctx = arg;
+
+    pthread_mutex_lock(&ctx->lock);
+    for (;;) {
+        while (!ctx->queue_head && !ctx->shutting_down) {
+            pthread_cond_wait(&ctx->work_ready, &ctx->lock);
+        }
+        if (!ctx->queue_head) {
+            break;
+        }
+
+        fe_job* job = ctx->queue_head;
+        queue_remove(ctx, job);
+        job->running = true;
+        pthread_mutex_unlock(&ctx->lock);
+
+        int error;
+        fe_job_status status = job->input_filename
+            ? run_file_job(job, &error)
+            : run_buffer_job(job, &error);
+
+        pthread_mutex_lock(&ctx->lock);
+        complete_job(ctx, job, status, error);
+    }
+    pthread_mutex_unlock(&ctx->lock);
+
+    return NULL;
+}
+
+fe_async* fe_async_create(unsigned int workers) {
+    if (workers == 0) {
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        workers = online > 0 ? (unsigned int)online : 1;
+    }
+
+    fe_async* ctx = calloc(1, sizeof(*ctx));
+    if (!ctx) {
+        return NULL;
+    }
+
+    ctx->workers = calloc(workers, sizeof(pthread_t));
+    ctx->live_buckets = calloc(ASYNC_INITIAL_BUCKETS, sizeof(*ctx->live_buckets));
+    ctx->live_bucket_count = ASYNC_INITIAL_BUCKETS;
+    ctx->event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    ctx->next_id = 1;
+
+    if (!ctx->workers || !ctx->live_buckets || ctx->event_fd < 0) {
+        if (ctx->event_fd >= 0) {
+            close(ctx->event_fd);
+        }
+        free(ctx->live_buckets);
+        free(ctx->workers);
+        free(ctx);
+        return NULL;
+    }
+
+    pthread_mutex_init(&ctx->lock, NULL);
+    pthread_cond_init(&ctx->work_ready, NULL);
+
+    for (unsigned int i = 0; i < workers; i++) {
+        if (pthread_create(&ctx->workers[i], NULL, worker_main, ctx) != 0) {
+            break;
+        }
+        ctx->worker_count++;
+    }
+
+    if (ctx->worker_count == 0) {
+        fe_async_destroy(ctx);
+        return NULL;
+    }
+
+    return ctx;
+}
+
+void fe_async_destroy(fe_async* ctx) {
+    if (!ctx) {
+        return;
+    }
+
+    // Drop pending jobs, ask running ones to stop, then wait for the workers
+    pthread_mutex_lock(&ctx->lock);
+    ctx->shutting_down = true;
+    while (ctx->queue_head) {
+        fe_job* job = ctx->queue_head;
+        queue_remove(ctx, job);
+        live_remove(ctx, job);
+        free_job(job);
+    }
+    for (size_t i = 0; i < ctx->live_bucket_count; i++) {
+        for (fe_job* job = ctx->live_buckets[i]; job; job = job->live_next) {
+            atomic_store_explicit(&job->cancelled, true, memory_order_relaxed);
+        }
+    }
+    pthread_cond_broadcast(&ctx->work_ready);
+    pthread_mutex_unlock(&ctx->lock);
+
+    for (unsigned int i = 0; i < ctx->worker_count; i++) {
+        pthread_join(ctx->workers[i], NULL);
+    }
+
+    while (ctx->done_head) {
+        completion_node* node = ctx->done_head;
+        ctx->done_head = node->next;
+        free(node);
+    }
+
+    close(ctx->event_fd);
+    pthread_cond_destroy(&ctx->work_ready);
+    pthread_mutex_destroy(&ctx->lock);
+    free(ctx->live_buckets);
+    free(ctx->workers);
+    free(ctx);
+}
+
+int fe_async_fd(const fe_async* ctx) {
+    return ctx ? ctx->event_fd : -1;
+}
+
+static fe_job_id submit_job(fe_async* ctx, fe_job* job) {
+    pthread_mutex_lock(&ctx->lock);
+
+    if (ctx->shutting_down) {
+        pthread_mutex_unlock(&ctx->lock);
+        free_job(job);
+        errno = ECANCELED;
+        return 0;
+    }
+
+    job->id = ctx->next_id++;
+    fe_job_id id = job->id;
+
+    job->queue_prev = ctx->queue_tail;
+    if (ctx->queue_tail) {
+        ctx->queue_tail->queue_next = job;
+    } else {
+        ctx->queue_head = job;
+    }
+    ctx->queue_tail = job;
+
+    live_insert(ctx, job);
+
+    pthread_cond_signal(&ctx->work_ready);
+    pthread_mutex_unlock(&ctx->lock);
+
+    return id;
+}
+
+fe_job_id fe_submit_file(fe_async* ctx, fe_job_op op, const char* input_filename,
+                         const char* output_filename, int key, void* user_data) {
+    // Validate input parameters
+    if (!ctx || !input_filename || !output_filename) {
+        errno = EINVAL;
+        return 0;
+    }
+
+    fe_job* job = calloc(1, sizeof(*job));
+    if (!job) {
+        return 0;
+    }
+
+    job->op = op;
+    job->key = key;
+    job->user_data = user_data;
+    job->done = malloc(sizeof(*job->done));
+    job->input_filename = strdup(input_filename);
+    job->output_filename = strdup(output_filename);
+
+    if (!job->done || !job->input_filename || !job->output_filename) {
+        free_job(job);
+        errno = ENOMEM;
+        return 0;
+    }
+
+    return submit_job(ctx, job);
+}
+
+fe_job_id fe_submit_buffer(fe_async* ctx, fe_job_op op, uint8_t* data, size_t length,
+                           int key, void* user_data) {
+    // Validate input parameters
+    if (!ctx || (!data && length > 0)) {
+        errno = EINVAL;
+        return 0;
+    }
+
+    fe_job* job = calloc(1, sizeof(*job));
+    if (!job) {
+        return 0;
+    }
+
+    job->op = op;
+    job->key = key;
+    job->user_data = user_data;
+    job->data = data;
+    job->length = length;
+    atomic_store_explicit(&job->bytes_total, length, memory_order_relaxed);
+
+    job->done = malloc(sizeof(*job->done));
+    if (!job->done) {
+        free_job(job);
+        errno = ENOMEM;
+        return 0;
+    }
+
+    return submit_job(ctx, job);
+}
+
+int fe_cancel(fe_async* ctx, fe_job_id id) {
+    if (!ctx) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&ctx->lock);
+
+    fe_job* job = find_live(ctx, id);
+    if (!job) {
+        pthread_mutex_unlock(&ctx->lock);
+        return -1;
+    }
+
+    if (job->running) {
+        // The worker notices between chunks and completes the job itself
+        atomic_store_explicit(&job->cancelled, true, memory_order_relaxed);
+    } else {
+        queue_remove(ctx, job);
+        complete_job(ctx, job, FE_JOB_CANCELLED, 0);
+    }
+
+    pthread_mutex_unlock(&ctx->lock);
+    return 0;
+}
+
+int fe_job_progress(fe_async* ctx, fe_job_id id, uint64_t* bytes_done, uint64_t* bytes_total) {
+    if (!ctx) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&ctx->lock);
+
+    fe_job* job = find_live(ctx, id);
+    if (job) {
+        if (bytes_done) {
+            *bytes_done = atomic_load_explicit(&job->bytes_done, memory_order_relaxed);
+        }
+        if (bytes_total) {
+            *bytes_total = atomic_load_explicit(&job->bytes_total, memory_order_relaxed);
+        }
+    }
+
+    pthread_mutex_unlock(&ctx->lock);
+    return job ? 0 : -1;
+}
+
+size_t fe_poll_completions(fe_async* ctx, fe_completion* completions, size_t max_completions) {
+    if (!ctx || !completions) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&ctx->lock);
+
+    size_t count = 0;
+    while (count < max_completions && ctx->done_head) {
+        completion_node* node = ctx->done_head;
+        ctx->done_head = node->next;
+        completions[count++] = node->completion;
+        free(node);
+    }
+    if (!ctx->done_head) {
+        ctx->done_tail = NULL;
+
+        // Queue drained: reset the eventfd so the loop stops waking up.
+        // If completions remain, the fd stays readable (level-triggered).
+        uint64_t pending;
+        ssize_t ignored = read(ctx->event_fd, &pending, sizeof(pending));
+        (void)ignored;
+    }
+
+    pthread_mutex_unlock(&ctx->lock);
+    return count;
+}
@@ -0,0 +1,61 @@
+#ifndef ASYNC_JOBS_H
+#define ASYNC_JOBS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Asynchronous encrypt/decrypt jobs for event-loop integration (Linux only).
+//
+// Jobs run on an internal worker pool. Finished jobs are queued as
+// completions and signalled through an eventfd, so a single epoll loop can
+// watch fe_async_fd() and call fe_poll_completions() when it turns readable.
+
+typedef struct fe_async fe_async;
+typedef uint64_t fe_job_id;   // 0 is never a valid id
+
+typedef enum {
+    FE_JOB_ENCRYPT,
+    FE_JOB_DECRYPT
+} fe_job_op;
+
+typedef enum {
+    FE_JOB_OK = 0,
+    FE_JOB_FAILED = -1,
+    FE_JOB_CANCELLED = -2
+} fe_job_status;
+
+typedef struct {
+    fe_job_id id;
+    fe_job_status status;
+    int error;                  // errno value when status is FE_JOB_FAILED
+    uint64_t bytes_processed;
+    void* user_data;
+} fe_completion;
+
+fe_async* fe_async_create(unsigned int workers);
+
+void fe_async_destroy(fe_async* ctx);
+
+int fe_async_fd(const fe_async* ctx);
+
+fe_job_id fe_submit_file(fe_async* ctx, fe_job_op op, const char* input_filename,
+                         const char* output_filename, int key, void* user_data);
+
+fe_job_id fe_submit_buffer(fe_async* ctx, fe_job_op op, uint8_t* data, size_t length,
+                           int key, void* user_data);
+
+int fe_cancel(fe_async* ctx, fe_job_id id);
+
+int fe_job_progress(fe_async* ctx, fe_job_id id, uint64_t* bytes_done, uint64_t* bytes_total);
+
+size_t fe_poll_completions(fe_async* ctx, fe_completion* completions, size_t max_completions);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ASYNC_JOBS_H
@@ -0,0 +1,277 @@
+#include "autotune.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define TUNE_PATH_MAX 4096
+#define TUNE_PROBE_SIZE (16 * 1024 * 1024)
+#define TUNE_PROBE_KEY 42
+
+static const size_t probe_block_sizes[] = {64 * 1024, 256 * 1024, 1024 * 1024, 4 * 1024 * 1024};
+static const unsigned int probe_thread_counts[] = {1, 2, 4, 8};
+
+const char* autotune_profile_path(void) {
+    static char path[TUNE_PATH_MAX];
+
+    const char* override = getenv("FE_TUNE_PROFILE");
+    if (override && *override) {
+        return override;
+    }
+
+    const char* cache_home = getenv("XDG_CACHE_HOME");
+    const char* home = getenv("HOME");
+    int length;
+    if (cache_home && *cache_home) {
+        length = snprintf(path, sizeof(path), "%s/file-encryptor/tune-profile", cache_home);
+    } else if (home && *home) {
+        length = snprintf(path, sizeof(path), "%s/.cache/file-encryptor/tune-profile", home);
+    } else {
+        return NULL;
+    }
+
+    return (length > 0 && (size_t)length < sizeof(path)) ? path : NULL;
+}
+
+int autotune_target(const char* output_filename, char* probe_dir, size_t probe_dir_size, dev_t* device) {
+    if (!output_filename || !probe_dir || probe_dir_size < 2 || !device) {
+        return -1;
+    }
+
+    // Probe the directory the output will be written to
+    const char* slash = strrchr(output_filename, '/');
+    if (!slash) {
+        strcpy(probe_dir, ".");
+    } else {
+        size_t length = (slash == output_filename) ? 1 : (size_t)(slash - output_filename);
+        if (length >= probe_dir_size) {
+            return -1;
+        }
+        memcpy(probe_dir, output_filename, length);
+        probe_dir[length] = '\0';
+    }
+
+    struct stat dir_stat;
+    if (stat(probe_dir, &dir_stat) != 0 || !S_ISDIR(dir_stat.st_mode)) {
+        return -1;
+    }
+
+    *device = dir_stat.st_dev;
+    return 0;
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static int write_probe_input(const char* path) {
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        return -1;
+    }
+
+    uint8_t* buffer = malloc(1024 * 1024);
+    int result = buffer ? 0 : -1;
+    for (size_t i = 0; buffer && i < 1024 * 1024; i++) {
+        buffer[i] = (uint8_t)(i * 31 + (i >> 8));
+    }
+
+    for (size_t done = 0; result == 0 && done < TUNE_PROBE_SIZE; done += 1024 * 1024) {
+        if (write(fd, buffer, 1024 * 1024) != 1024 * 1024) {
+            result = -1;
+        }
+    }
+
+    // Flush so probes can drop the file from the page cache and read it cold
+    if (result == 0 && fsync(fd) != 0) {
+        result = -1;
+    }
+
+    free(buffer);
+    close(fd);
+    return result;
+}
+
+static void drop_cached_pages(const char* path) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+    }
+}
+
+int autotune_calibrate(const char* probe_dir, tune_profile* best) {
+    if (!probe_dir || !best) {
+        return -1;
+    }
+
+    char input_path[TUNE_PATH_MAX];
+    char output_path[TUNE_PATH_MAX];
+    int in_length = snprintf(input_path, sizeof(input_path), "%s/.fe-autotune-%ld.in", probe_dir, (long)getpid());
+    int out_length = snprintf(output_path, sizeof(output_path), "%s/.fe-autotune-%ld.out", probe_dir, (long)getpid());
+    if (in_length < 0 || (size_t)in_length >= sizeof(input_path) ||
+        out_length < 0 || (size_t)out_length >= sizeof(output_path)) {
+        return -1;
+    }
+
+    if (write_probe_input(input_path) != 0) {
+        unlink(input_path);
+        return -1;
+    }
+
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    unsigned int max_threads = online > 0 ? (unsigned int)online : 1;
+
+    bool found = false;
+    for (int backend = 0; backend < ENGINE_BACKEND_COUNT; backend++) {
+        for (size_t b = 0; b < sizeof(probe_block_sizes) / sizeof(probe_block_sizes[0]); b++) {
+            for (size_t t = 0; t < sizeof(probe_thread_counts) / sizeof(probe_thread_counts[0]); t++) {
+                if (probe_thread_counts[t] > max_threads && probe_thread_counts[t] > 1) {
+                    continue;
+                }
+
+                engine_params params = {
+                    .backend = (engine_backend)backend,
+                    .block_size = probe_block_sizes[b],
+                    .threads = probe_thread_counts[t]
+                };
+
+                drop_cached_pages(input_path);
+
+                // Backends the filesystem rejects (e.g. O_DIRECT on tmpfs) simply lose
+                double start = now_seconds();
+                if (engine_transform_file(input_path, output_path, TUNE_PROBE_KEY, ENGINE_ENCRYPT, &params, NULL, NULL) != 0) {
+                    continue;
+                }
+                double elapsed = now_seconds() - start;
+                double mbps = elapsed > 0 ? (TUNE_PROBE_SIZE / (1024.0 * 1024.0)) / elapsed : 0.0;
+
+                if (!found || mbps > best->mbps) {
+                    best->params = params;
+                    best->mbps = mbps;
+                    found = true;
+                }
+            }
+        }
+    }
+
+    unlink(input_path);
+    unlink(output_path);
+    return found ? 0 : -1;
+}
+
+int autotune_load(dev_t device, tune_profile* profile) {
+    const char* path = autotune_profile_path();
+    if (!path || !profile) {
+        return -1;
+    }
+
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        return -1;
+    }
+
+    // Each line: <st_dev> <backend> <block_size> <threads> <mbps>
+    char line[256];
+    int result = -1;
+    while (result != 0 && fgets(line, sizeof(line), file)) {
+        unsigned long long entry_device;
+        char backend_name[32];
+        size_t block_size;
+        unsigned int threads;
+        double mbps;
+
+        if (line[0] == '#' ||
+            sscanf(line, "%llu %31s %zu %u %lf", &entry_device, backend_name, &block_size, &threads, &mbps) != 5 ||
+            entry_device != (unsigned long long)device) {
+            continue;
+        }
+
+        engine_backend backend;
+        if (engine_backend_from_name(backend_name, &backend) != 0 ||
+            block_size == 0 || block_size % ENGINE_ALIGNMENT != 0 || threads == 0) {
+            continue;
+        }
+
+        profile->params.backend = backend;
+        profile->params.block_size = block_size;
+        profile->params.threads = threads;
+        profile->mbps = mbps;
+        result = 0;
+    }
+
+    fclose(file);
+    return result;
+}
+
+static int make_parent_dirs(const char* path) {
+    char buffer[TUNE_PATH_MAX];
+    if (strlen(path) >= sizeof(buffer)) {
+        return -1;
+    }
+    strcpy(buffer, path);
+
+    for (char* p = buffer + 1; *p; p++) {
+        if (*p == '/') {
+            *p = '\0';
+            if (mkdir(buffer, 0755) != 0 && errno != EEXIST) {
+                return -1;
+            }
+            *p = '/';
+        }
+    }
+    return 0;
+}
+
+int autotune_save(dev_t device, const tune_profile* profile) {
+    const char* path = autotune_profile_path();
+    if (!path || !profile || make_parent_dirs(path) != 0) {
+        return -1;
+    }
+
+    char temp_path[TUNE_PATH_MAX];
+    int length = snprintf(temp_path, sizeof(temp_path), "%s.tmp.%ld", path, (long)getpid());
+    if (length < 0 || (size_t)length >= sizeof(temp_path)) {
+        return -1;
+    }
+
+    FILE* output = fopen(temp_path, "w");
+    if (!output) {
+        return -1;
+    }
+
+    fprintf(output, "# file-encryptor tuning profile: st_dev backend block_size threads mbps\n");
+
+    // Keep entries for other filesystems
+    FILE* input = fopen(path, "r");
+    if (input) {
+        char line[256];
+        while (fgets(line, sizeof(line), input)) {
+            unsigned long long entry_device;
+            if (line[0] == '#' || sscanf(line, "%llu", &entry_device) != 1 ||
+                entry_device == (unsigned long long)device) {
+                continue;
+            }
+            fputs(line, output);
+        }
+        fclose(input);
+    }
+
+    fprintf(output, "%llu %s %zu %u %.1f\n", (unsigned long long)device,
+            engine_backend_name(profile->params.backend), profile->params.block_size,
+            profile->params.threads, profile->mbps);
+
+    if (fclose(output) != 0 || rename(temp_path, path) != 0) {
+        unlink(temp_path);
+        return -1;
+    }
+    return 0;
+}
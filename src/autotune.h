@@ -0,0 +1,38 @@
+#ifndef AUTOTUNE_H
+#define AUTOTUNE_H
+
+#include <stddef.h>
+#include <sys/types.h>
+#include "engine.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Per-filesystem calibration of engine parameters (Linux only).
+//
+// autotune_calibrate() times short probe runs of every backend, block size
+// and thread count in a directory and keeps the fastest. Results are stored
+// in a small text profile keyed by st_dev, so later runs on the same
+// filesystem can reuse them without probing.
+
+typedef struct {
+    engine_params params;
+    double mbps;    // Probe throughput of params at calibration time
+} tune_profile;
+
+int autotune_target(const char* output_filename, char* probe_dir, size_t probe_dir_size, dev_t* device);
+
+int autotune_calibrate(const char* probe_dir, tune_profile* best);
+
+int autotune_load(dev_t device, tune_profile* profile);
+
+int autotune_save(dev_t device, const tune_profile* profile);
+
+const char* autotune_profile_path(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AUTOTUNE_H
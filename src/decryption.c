@@ -1,8 +1,19 @@
 #include "decryption.h"
+#include "progress.h"
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
 
+#ifdef __linux__
+// The streams never leave this file, so skip the per-byte stdio locking
+// glibc switches on once a second thread (e.g. a progress reporter) exists
+#define read_byte getc_unlocked
+#define write_byte putc_unlocked
+#else
+#define read_byte fgetc
+#define write_byte fputc
+#endif
+
 uint8_t decrypt_byte(uint8_t encrypted_byte, int key) {
     // Normalize key to positive range and apply modulo 256
     // This ensures the key works correctly even if negative or large
@@ -13,7 +24,25 @@ uint8_t decrypt_byte(uint8_t encrypted_byte, int key) {
     return (uint8_t)((encrypted_byte - normalized_key + 256) % 256);
 }
 
+void decrypt_buffer(uint8_t* data, size_t length, int key) {
+    if (!data) {
+        return;
+    }
+    
+    // Normalize once; 8-bit wraparound makes the subtraction exact modulo 256
+    uint8_t shift = (uint8_t)(((key % 256) + 256) % 256);
+    
+    for (size_t i = 0; i < length; i++) {
+        data[i] = (uint8_t)(data[i] - shift);
+    }
+}
+
 int decrypt_file(const char* input_filename, const char* output_filename, int key) {
+    return decrypt_file_with_progress(input_filename, output_filename, key, NULL);
+}
+
+int decrypt_file_with_progress(const char* input_filename, const char* output_filename, int key,
+                               struct fe_progress* progress) {
     // Validate input parameters
     if (!input_filename || !output_filename) {
         fprintf(stderr, "Error: Invalid filename parameters\n");
@@ -37,16 +66,16 @@ int decrypt_file(const char* input_filename, const char* output_filename, int ke
     
     // Process file byte by byte
     int byte;
-    size_t bytes_processed = 0;
+    uint64_t bytes_processed = 0;
     
     printf("Decrypting file '%s' to '%s' with key %d...\n", input_filename, output_filename, key);
     
-    while ((byte = fgetc(input_file)) != EOF) {
+    while ((byte = read_byte(input_file)) != EOF) {
         // Decrypt the byte
         uint8_t decrypted_byte = decrypt_byte((uint8_t)byte, key);
         
         // Write decrypted byte to output file
-        if (fputc(decrypted_byte, output_file) == EOF) {
+        if (write_byte(decrypted_byte, output_file) == EOF) {
             fprintf(stderr, "Error: Failed to write to output file\n");
             fclose(input_file);
             fclose(output_file);
@@ -54,12 +83,19 @@ int decrypt_file(const char* input_filename, const char* output_filename, int ke
         }
         
         bytes_processed++;
+        
+        // Publish progress periodically; a relaxed store, no syscall
+        if ((bytes_processed & (FE_PROGRESS_STRIDE - 1)) == 0) {
+            progress_publish(progress, bytes_processed);
+        }
     }
     
+    progress_publish(progress, bytes_processed);
+    
     // Close files
     fclose(input_file);
     fclose(output_file);
     
-    printf("Decryption completed successfully. Processed %zu bytes.\n", bytes_processed);
+    printf("Decryption completed successfully. Processed %llu bytes.\n", (unsigned long long)bytes_processed);
     return 0;
 }
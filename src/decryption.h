@@ -3,9 +3,25 @@
 
 #include <stdint.h>
 #include <stdio.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
 
 uint8_t decrypt_byte(uint8_t encrypted_byte, int key);
 
+void decrypt_buffer(uint8_t* data, size_t length, int key);
+
 int decrypt_file(const char* input_filename, const char* output_filename, int key);
 
+struct fe_progress;
+
+int decrypt_file_with_progress(const char* input_filename, const char* output_filename, int key,
+                               struct fe_progress* progress);
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif // DECRYPTION_H
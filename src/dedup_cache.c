@@ -0,0 +1,318 @@
+#ifdef __linux__
+#define _GNU_SOURCE // copy_file_range
+#endif
+
+#include "dedup_cache.h"
+#include "encryption.h"
+#include "decryption.h"
+#include "progress.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+#endif
+
+#define CACHE_PATH_MAX 4096
+#define CACHE_IO_CHUNK (64 * 1024)
+
+const char* cache_link_method_name(cache_link_method method) {
+    switch (method) {
+        case CACHE_LINK_REFLINK: return "reflink";
+        case CACHE_LINK_COPY:    return "copy";
+        default:                 return "none";
+    }
+}
+
+// Entries are addressed by a cryptographic digest: a hit returns the stored
+// output without comparing contents, so colliding inputs must be infeasible
+int dedup_hash_file(const char* filename, uint8_t digest[SHA256_DIGEST_SIZE]) {
+    if (!filename || !digest) {
+        return -1;
+    }
+
+    FILE* file = fopen(filename, "rb");
+    if (!file) {
+        return -1;
+    }
+
+    uint8_t* buffer = malloc(CACHE_IO_CHUNK);
+    if (!buffer) {
+        fclose(file);
+        return -1;
+    }
+
+    sha256_ctx ctx;
+    sha256_init(&ctx);
+    size_t n;
+    while ((n = fread(buffer, 1, CACHE_IO_CHUNK, file)) > 0) {
+        sha256_update(&ctx, buffer, n);
+    }
+
+    int result = ferror(file) ? -1 : 0;
+    free(buffer);
+    fclose(file);
+
+    if (result == 0) {
+        sha256_final(&ctx, digest);
+    }
+    return result;
+}
+
+// Entry names encode everything the cached output depends on
+static bool build_entry_path(char* path, size_t size, const char* size_dir,
+                             const uint8_t digest[SHA256_DIGEST_SIZE], cache_mode mode, int normalized_key) {
+    char hex[SHA256_DIGEST_SIZE * 2 + 1];
+    for (int i = 0; i < SHA256_DIGEST_SIZE; i++) {
+        snprintf(hex + i * 2, 3, "%02x", digest[i]);
+    }
+
+    int length = snprintf(path, size, "%s/%s-%c%03d", size_dir, hex, (char)mode, normalized_key);
+    return length > 0 && (size_t)length < size;
+}
+
+static int make_dir(const char* path) {
+#ifdef _WIN32
+    int result = _mkdir(path);
+#else
+    int result = mkdir(path, 0755);
+#endif
+    return (result == 0 || errno == EEXIST) ? 0 : -1;
+}
+
+#ifdef __linux__
+// Share the source extents with the destination (btrfs, XFS, bcachefs, ...)
+static bool try_reflink(const char* src, const char* dst) {
+    int in = open(src, O_RDONLY);
+    if (in < 0) {
+        return false;
+    }
+
+    int out = open(dst, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (out < 0) {
+        close(in);
+        return false;
+    }
+
+    bool ok = ioctl(out, FICLONE, in) == 0;
+    close(in);
+    close(out);
+    if (!ok) {
+        unlink(dst);
+    }
+    return ok;
+}
+
+// In-kernel copy; avoids bouncing the data through user space
+static bool try_copy_file_range(const char* src, const char* dst) {
+    int in = open(src, O_RDONLY);
+    if (in < 0) {
+        return false;
+    }
+
+    struct stat src_stat;
+    if (fstat(in, &src_stat) != 0) {
+        close(in);
+        return false;
+    }
+
+    int out = open(dst, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (out < 0) {
+        close(in);
+        return false;
+    }
+
+    off_t remaining = src_stat.st_size;
+    bool ok = true;
+    while (remaining > 0) {
+        ssize_t copied = copy_file_range(in, NULL, out, NULL, (size_t)remaining, 0);
+        if (copied <= 0) {
+            ok = false;
+            break;
+        }
+        remaining -= copied;
+    }
+
+    close(in);
+    close(out);
+    if (!ok) {
+        unlink(dst);
+    }
+    return ok;
+}
+#endif
+
+static bool copy_stream(const char* src, const char* dst) {
+    FILE* in = fopen(src, "rb");
+    if (!in) {
+        return false;
+    }
+
+    FILE* out = fopen(dst, "wb");
+    if (!out) {
+        fclose(in);
+        return false;
+    }
+
+    uint8_t* buffer = malloc(CACHE_IO_CHUNK);
+    bool ok = buffer != NULL;
+    size_t n;
+    while (ok && (n = fread(buffer, 1, CACHE_IO_CHUNK, in)) > 0) {
+        ok = fwrite(buffer, 1, n, out) == n;
+    }
+    ok = ok && !ferror(in);
+
+    free(buffer);
+    fclose(in);
+    ok = (fclose(out) == 0) && ok;
+    if (!ok) {
+        remove(dst);
+    }
+    return ok;
+}
+
+// Make dst an independent copy of src using the cheapest method the
+// filesystem supports. Hard links are never used: later runs without the
+// cache truncate outputs in place, which would rewrite a shared entry.
+// Every method opens dst with truncation, so an existing output is
+// overwritten in place rather than replaced.
+static cache_link_method materialize(const char* src, const char* dst) {
+#ifdef __linux__
+    if (try_reflink(src, dst)) {
+        return CACHE_LINK_REFLINK;
+    }
+#endif
+
+#ifdef __linux__
+    if (try_copy_file_range(src, dst)) {
+        return CACHE_LINK_COPY;
+    }
+#endif
+
+    return copy_stream(src, dst) ? CACHE_LINK_COPY : CACHE_LINK_NONE;
+}
+
+int cached_transform_file(const char* cache_dir, const char* input_filename,
+                          const char* output_filename, int key, cache_mode mode,
+                          dedup_stats* stats, fe_progress* progress) {
+    // Validate input parameters
+    if (!cache_dir || !input_filename || !output_filename) {
+        fprintf(stderr, "Error: Invalid cache parameters\n");
+        return -1;
+    }
+
+    int (*transform)(const char*, const char*, int, fe_progress*) =
+        (mode == CACHE_MODE_DECRYPT) ? decrypt_file_with_progress : encrypt_file_with_progress;
+
+    // Let the transform report missing or unreadable inputs
+    struct stat input_stat;
+    if (stat(input_filename, &input_stat) != 0) {
+        return transform(input_filename, output_filename, key, progress);
+    }
+
+    // Pipes and devices are written through without the cache; a failed
+    // materialization would otherwise unlink them
+    struct stat output_stat;
+    if (stat(output_filename, &output_stat) == 0 && !S_ISREG(output_stat.st_mode)) {
+        return transform(input_filename, output_filename, key, progress);
+    }
+
+    // Keys are cached in normalized form so that e.g. 42 and 298 share entries
+    int normalized_key = ((key % 256) + 256) % 256;
+    unsigned long long input_size = (unsigned long long)input_stat.st_size;
+
+    // Entries live under <cache_dir>/<size>/<sha256>-<mode><key>, so a file whose
+    // size has never been seen is a miss without hashing its content
+    char size_dir[CACHE_PATH_MAX];
+    char entry_path[CACHE_PATH_MAX];
+    int length = snprintf(size_dir, sizeof(size_dir), "%s/%llu", cache_dir, input_size);
+    if (length < 0 || (size_t)length >= sizeof(size_dir)) {
+        fprintf(stderr, "Warning: Cache path too long; caching disabled\n");
+        return transform(input_filename, output_filename, key, progress);
+    }
+
+    struct stat entry_stat;
+    bool hashed = false;
+    uint8_t digest[SHA256_DIGEST_SIZE];
+
+    if (stat(size_dir, &entry_stat) == 0 && dedup_hash_file(input_filename, digest) == 0) {
+        hashed = true;
+
+        if (build_entry_path(entry_path, sizeof(entry_path), size_dir, digest, mode, normalized_key) &&
+            stat(entry_path, &entry_stat) == 0) {
+            cache_link_method method = materialize(entry_path, output_filename);
+            if (method != CACHE_LINK_NONE) {
+                if (stats) {
+                    stats->hits++;
+                    stats->bytes_reused += input_size;
+                    stats->last_method = method;
+                }
+                progress_publish(progress, input_size);
+                printf("Cache hit: '%s' reused for '%s' via %s.\n",
+                       entry_path, output_filename, cache_link_method_name(method));
+                return 0;
+            }
+            fprintf(stderr, "Warning: Could not reuse cache entry '%s'\n", entry_path);
+        }
+    }
+
+    if (stats) {
+        stats->misses++;
+    }
+
+    int result = transform(input_filename, output_filename, key, progress);
+    if (result != 0) {
+        return result;
+    }
+
+    // Populating the cache is best effort; the output is already complete
+    if (!hashed && dedup_hash_file(input_filename, digest) != 0) {
+        fprintf(stderr, "Warning: Could not hash '%s'; result not cached\n", input_filename);
+        return 0;
+    }
+    if (!build_entry_path(entry_path, sizeof(entry_path), size_dir, digest, mode, normalized_key)) {
+        fprintf(stderr, "Warning: Cache path too long; result not cached\n");
+        return 0;
+    }
+
+    if (make_dir(cache_dir) != 0 || make_dir(size_dir) != 0) {
+        fprintf(stderr, "Warning: Could not create cache directory '%s'\n", size_dir);
+        return 0;
+    }
+
+    // Publish atomically so concurrent runs never see a partial entry
+    char temp_path[CACHE_PATH_MAX];
+    length = snprintf(temp_path, sizeof(temp_path), "%s.tmp.%ld", entry_path, (long)getpid());
+
+    if (length < 0 || (size_t)length >= sizeof(temp_path) ||
+        materialize(output_filename, temp_path) == CACHE_LINK_NONE) {
+        fprintf(stderr, "Warning: Could not store '%s' in cache\n", output_filename);
+        return 0;
+    }
+
+    // Entries are never modified once published
+    chmod(temp_path, 0444);
+
+    if (rename(temp_path, entry_path) != 0) {
+        remove(temp_path);
+        fprintf(stderr, "Warning: Could not store '%s' in cache\n", output_filename);
+    }
+
+    return 0;
+}
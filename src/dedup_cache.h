@@ -0,0 +1,38 @@
+#ifndef DEDUP_CACHE_H
+#define DEDUP_CACHE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "sha256.h"
+
+// Which transform a cache entry was produced by
+typedef enum {
+    CACHE_MODE_ENCRYPT = 'e',
+    CACHE_MODE_DECRYPT = 'd'
+} cache_mode;
+
+// How a cached output was materialized (cheapest method that worked)
+typedef enum {
+    CACHE_LINK_NONE = 0,
+    CACHE_LINK_REFLINK,
+    CACHE_LINK_COPY
+} cache_link_method;
+
+typedef struct {
+    size_t hits;
+    size_t misses;
+    uint64_t bytes_reused;           // Input bytes satisfied from the cache
+    cache_link_method last_method;   // Method used by the most recent hit
+} dedup_stats;
+
+int dedup_hash_file(const char* filename, uint8_t digest[SHA256_DIGEST_SIZE]);
+
+struct fe_progress;
+
+int cached_transform_file(const char* cache_dir, const char* input_filename,
+                          const char* output_filename, int key, cache_mode mode,
+                          dedup_stats* stats, struct fe_progress* progress);
+
+const char* cache_link_method_name(cache_link_method method);
+
+#endif // DEDUP_CACHE_H
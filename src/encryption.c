@@ -1,8 +1,19 @@
 #include "encryption.h"
+#include "progress.h"
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
 
+#ifdef __linux__
+// The streams never leave this file, so skip the per-byte stdio locking
+// glibc switches on once a second thread (e.g. a progress reporter) exists
+#define read_byte getc_unlocked
+#define write_byte putc_unlocked
+#else
+#define read_byte fgetc
+#define write_byte fputc
+#endif
+
 uint8_t encrypt_byte(uint8_t byte, int key) {
     // Normalize key to positive range and apply modulo 256
     // This ensures the key works correctly even if negative or large
@@ -12,7 +23,25 @@ uint8_t encrypt_byte(uint8_t byte, int key) {
     return (uint8_t)((byte + normalized_key) % 256);
 }
 
+void encrypt_buffer(uint8_t* data, size_t length, int key) {
+    if (!data) {
+        return;
+    }
+    
+    // Normalize once so the loop body is a plain 8-bit add the compiler can vectorize
+    uint8_t shift = (uint8_t)(((key % 256) + 256) % 256);
+    
+    for (size_t i = 0; i < length; i++) {
+        data[i] = (uint8_t)(data[i] + shift);
+    }
+}
+
 int encrypt_file(const char* input_filename, const char* output_filename, int key) {
+    return encrypt_file_with_progress(input_filename, output_filename, key, NULL);
+}
+
+int encrypt_file_with_progress(const char* input_filename, const char* output_filename, int key,
+                               struct fe_progress* progress) {
     // Validate input parameters
     if (!input_filename || !output_filename) {
         fprintf(stderr, "Error: Invalid filename parameters\n");
@@ -36,16 +65,16 @@ int encrypt_file(const char* input_filename, const char* output_filename, int ke
     
     // Process file byte by byte
     int byte;
-    size_t bytes_processed = 0;
+    uint64_t bytes_processed = 0;
     
     printf("Encrypting file '%s' to '%s' with key %d...\n", input_filename, output_filename, key);
     
-    while ((byte = fgetc(input_file)) != EOF) {
+    while ((byte = read_byte(input_file)) != EOF) {
         // Encrypt the byte
         uint8_t encrypted_byte = encrypt_byte((uint8_t)byte, key);
         
         // Write encrypted byte to output file
-        if (fputc(encrypted_byte, output_file) == EOF) {
+        if (write_byte(encrypted_byte, output_file) == EOF) {
             fprintf(stderr, "Error: Failed to write to output file\n");
             fclose(input_file);
             fclose(output_file);
@@ -53,12 +82,19 @@ int encrypt_file(const char* input_filename, const char* output_filename, int ke
         }
         
         bytes_processed++;
+        
+        // Publish progress periodically; a relaxed store, no syscall
+        if ((bytes_processed & (FE_PROGRESS_STRIDE - 1)) == 0) {
+            progress_publish(progress, bytes_processed);
+        }
     }
     
+    progress_publish(progress, bytes_processed);
+    
     // Close files
     fclose(input_file);
     fclose(output_file);
     
-    printf("Encryption completed successfully. Processed %zu bytes.\n", bytes_processed);
+    printf("Encryption completed successfully. Processed %llu bytes.\n", (unsigned long long)bytes_processed);
     return 0;
 }
@@ -3,9 +3,25 @@
 
 #include <stdint.h>
 #include <stdio.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
 
 uint8_t encrypt_byte(uint8_t byte, int key);
 
+void encrypt_buffer(uint8_t* data, size_t length, int key);
+
 int encrypt_file(const char* input_filename, const char* output_filename, int key);
 
+struct fe_progress;
+
+int encrypt_file_with_progress(const char* input_filename, const char* output_filename, int key,
+                               struct fe_progress* progress);
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif // ENCRYPTION_H
@@ -0,0 +1,371 @@
+#define _GNU_SOURCE // O_DIRECT
+
+#include "engine.h"
+#include "encryption.h"
+#include "decryption.h"
+#include "progress.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define ENGINE_MAX_THREADS 64
+
+static const char* const backend_names[ENGINE_BACKEND_COUNT] = {
+    "readwrite",
+    "mmap",
+    "direct"
+};
+
+typedef struct {
+    const engine_params* params;
+    engine_op op;
+    int key;
+    fe_progress* progress;
+
+    int input_fd;
+    int output_fd;
+    const uint8_t* input_map;
+    uint8_t* output_map;
+
+    uint64_t start;
+    uint64_t end;
+    int error;
+} engine_range;
+
+const char* engine_backend_name(engine_backend backend) {
+    return (backend >= 0 && backend < ENGINE_BACKEND_COUNT) ? backend_names[backend] : "unknown";
+}
+
+int engine_backend_from_name(const char* name, engine_backend* backend) {
+    for (int i = 0; name && i < ENGINE_BACKEND_COUNT; i++) {
+        if (strcmp(name, backend_names[i]) == 0) {
+            *backend = (engine_backend)i;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+static void transform_block(engine_op op, uint8_t* data, size_t length, int key) {
+    if (op == ENGINE_DECRYPT) {
+        decrypt_buffer(data, length, key);
+    } else {
+        encrypt_buffer(data, length, key);
+    }
+}
+
+// Read up to length bytes at offset; short only at end of file
+static ssize_t pread_full(int fd, uint8_t* data, size_t length, uint64_t offset) {
+    size_t done = 0;
+    while (done < length) {
+        ssize_t n = pread(fd, data + done, length - done, (off_t)(offset + done));
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        if (n == 0) {
+            break;
+        }
+        done += (size_t)n;
+    }
+    return (ssize_t)done;
+}
+
+static int pwrite_full(int fd, const uint8_t* data, size_t length, uint64_t offset) {
+    size_t done = 0;
+    while (done < length) {
+        ssize_t n = pwrite(fd, data + done, length - done, (off_t)(offset + done));
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        done += (size_t)n;
+    }
+    return 0;
+}
+
+static int run_range_readwrite(engine_range* range) {
+    size_t block_size = range->params->block_size;
+
+    // O_DIRECT needs aligned buffers; harmless for buffered reads
+    void* memory = NULL;
+    if (posix_memalign(&memory, ENGINE_ALIGNMENT, block_size) != 0) {
+        return ENOMEM;
+    }
+    uint8_t* buffer = memory;
+
+    int error = 0;
+    for (uint64_t offset = range->start; offset < range->end; offset += block_size) {
+        size_t length = (range->end - offset) < block_size ? (size_t)(range->end - offset) : block_size;
+
+        // Direct reads must be a multiple of the alignment; the tail read comes back short
+        size_t request = length;
+        if (range->params->backend == ENGINE_BACKEND_DIRECT) {
+            request = (length + ENGINE_ALIGNMENT - 1) / ENGINE_ALIGNMENT * ENGINE_ALIGNMENT;
+        }
+
+        ssize_t n = pread_full(range->input_fd, buffer, request, offset);
+        if (n < 0) {
+            error = errno;
+            break;
+        }
+        if ((size_t)n < length) {
+            error = EIO; // Input shrank while being processed
+            break;
+        }
+
+        transform_block(range->op, buffer, length, range->key);
+
+        if (pwrite_full(range->output_fd, buffer, length, offset) != 0) {
+            error = errno;
+            break;
+        }
+
+        progress_add(range->progress, length);
+    }
+
+    free(buffer);
+    return error;
+}
+
+static int run_range_mmap(engine_range* range) {
+    size_t block_size = range->params->block_size;
+
+    // Copy then transform block by block so each block is still cache-hot
+    for (uint64_t offset = range->start; offset < range->end; offset += block_size) {
+        size_t length = (range->end - offset) < block_size ? (size_t)(range->end - offset) : block_size;
+        memcpy(range->output_map + offset, range->input_map + offset, length);
+        transform_block(range->op, range->output_map + offset, length, range->key);
+        progress_add(range->progress, length);
+    }
+    return 0;
+}
+
+static void* range_main(void* arg) {
+    engine_range* range = arg;
+    range->error = (range->params->backend == ENGINE_BACKEND_MMAP)
+        ? run_range_mmap(range)
+        : run_range_readwrite(range);
+    return NULL;
+}
+
+// False if the filesystem rejects aligned reads on an O_DIRECT descriptor
+static bool direct_reads_work(int fd) {
+    void* memory = NULL;
+    if (posix_memalign(&memory, ENGINE_ALIGNMENT, ENGINE_ALIGNMENT) != 0) {
+        return false;
+    }
+    bool ok = pread_full(fd, memory, ENGINE_ALIGNMENT, 0) >= 0 || errno != EINVAL;
+    free(memory);
+    return ok;
+}
+
+static bool valid_params(const engine_params* params) {
+    return params &&
+           params->backend >= 0 && params->backend < ENGINE_BACKEND_COUNT &&
+           params->block_size > 0 && params->block_size % ENGINE_ALIGNMENT == 0 &&
+           params->threads > 0;
+}
+
+int engine_transform_file(const char* input_filename, const char* output_filename, int key,
+                          engine_op op, const engine_params* params, uint64_t* bytes_processed,
+                          fe_progress* progress) {
+    // Validate input parameters
+    if (!input_filename || !output_filename || !valid_params(params)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    // The profile was measured on the output's filesystem; if the input's
+    // filesystem cannot do direct I/O or mmap, read it through the page cache
+    engine_params effective = *params;
+
+    int input_fd = -1;
+    if (effective.backend == ENGINE_BACKEND_DIRECT) {
+        input_fd = open(input_filename, O_RDONLY | O_CLOEXEC | O_DIRECT);
+        if (input_fd < 0 && errno == EINVAL) {
+            effective.backend = ENGINE_BACKEND_READWRITE;
+        }
+    }
+    if (effective.backend != ENGINE_BACKEND_DIRECT) {
+        input_fd = open(input_filename, O_RDONLY | O_CLOEXEC);
+    }
+    if (input_fd < 0) {
+        return -1;
+    }
+
+    struct stat input_stat;
+    if (fstat(input_fd, &input_stat) != 0) {
+        int saved = errno;
+        close(input_fd);
+        errno = saved;
+        return -1;
+    }
+    
+    // Ranges are sized from st_size, which pipes and devices do not report;
+    // reject them before the output is truncated
+    if (!S_ISREG(input_stat.st_mode)) {
+        close(input_fd);
+        errno = S_ISDIR(input_stat.st_mode) ? EISDIR : ESPIPE;
+        return -1;
+    }
+    uint64_t size = (uint64_t)input_stat.st_size;
+
+    // Some filesystems accept O_DIRECT at open but reject the reads; probe
+    // one aligned block while the output is still untouched
+    if (effective.backend == ENGINE_BACKEND_DIRECT && size > 0 && !direct_reads_work(input_fd)) {
+        close(input_fd);
+        effective.backend = ENGINE_BACKEND_READWRITE;
+        input_fd = open(input_filename, O_RDONLY | O_CLOEXEC);
+        if (input_fd < 0) {
+            return -1;
+        }
+    }
+
+    const uint8_t* input_map = NULL;
+    if (effective.backend == ENGINE_BACKEND_MMAP && size > 0) {
+        void* in = mmap(NULL, size, PROT_READ, MAP_SHARED, input_fd, 0);
+        if (in == MAP_FAILED) {
+            effective.backend = ENGINE_BACKEND_READWRITE;
+        } else {
+            madvise(in, size, MADV_SEQUENTIAL);
+            input_map = in;
+        }
+    }
+
+    // Outputs are sized and written by offset, and removed on failure, so
+    // FIFOs and devices (/dev/stdout, /dev/null) must be left alone
+    struct stat output_stat;
+    if (stat(output_filename, &output_stat) == 0 && !S_ISREG(output_stat.st_mode)) {
+        if (input_map) {
+            munmap((void*)input_map, size);
+        }
+        close(input_fd);
+        errno = S_ISDIR(output_stat.st_mode) ? EISDIR : ESPIPE;
+        return -1;
+    }
+
+    // mmap needs read access to the output mapping
+    int output_fd = open(output_filename, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (output_fd < 0) {
+        int saved = errno;
+        if (input_map) {
+            munmap((void*)input_map, size);
+        }
+        close(input_fd);
+        errno = saved;
+        return -1;
+    }
+
+    // Re-check what was actually opened; it may have been replaced meanwhile
+    if (fstat(output_fd, &output_stat) != 0 || !S_ISREG(output_stat.st_mode)) {
+        if (input_map) {
+            munmap((void*)input_map, size);
+        }
+        close(output_fd);
+        close(input_fd);
+        errno = ESPIPE;
+        return -1;
+    }
+
+    // Size the output up front so ranges can be written independently
+    int error = 0;
+    if (ftruncate(output_fd, (off_t)size) != 0) {
+        error = errno;
+    }
+
+    uint8_t* output_map = NULL;
+    if (!error && input_map) {
+        // Stores into a sparse mapping raise SIGBUS when the disk fills up;
+        // reserve the blocks now so a full disk is an ordinary error
+        error = posix_fallocate(output_fd, 0, (off_t)size);
+    }
+    if (!error && input_map) {
+        void* out = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, output_fd, 0);
+        if (out == MAP_FAILED) {
+            error = errno;
+        } else {
+            madvise(out, size, MADV_SEQUENTIAL);
+            output_map = out;
+        }
+    }
+
+    // Split into block-aligned ranges, one per thread
+    uint64_t blocks = (size + effective.block_size - 1) / effective.block_size;
+    unsigned int threads = effective.threads > ENGINE_MAX_THREADS ? ENGINE_MAX_THREADS : effective.threads;
+    if (blocks < threads) {
+        threads = blocks > 0 ? (unsigned int)blocks : 1;
+    }
+    uint64_t range_size = (blocks + threads - 1) / threads * effective.block_size;
+
+    engine_range ranges[ENGINE_MAX_THREADS];
+    pthread_t workers[ENGINE_MAX_THREADS];
+    unsigned int started = 0;
+
+    for (unsigned int t = 0; !error && t < threads; t++) {
+        engine_range* range = &ranges[t];
+        range->params = &effective;
+        range->op = op;
+        range->key = key;
+        range->progress = progress;
+        range->input_fd = input_fd;
+        range->output_fd = output_fd;
+        range->input_map = input_map;
+        range->output_map = output_map;
+        range->start = t * range_size < size ? t * range_size : size;
+        range->end = (t + 1) * range_size < size ? (t + 1) * range_size : size;
+        range->error = 0;
+
+        // The calling thread takes the last range itself
+        if (t + 1 == threads) {
+            range_main(range);
+        } else if (pthread_create(&workers[t], NULL, range_main, range) != 0) {
+            error = EAGAIN;
+            break;
+        } else {
+            started++;
+        }
+    }
+
+    for (unsigned int t = 0; t < started; t++) {
+        pthread_join(workers[t], NULL);
+    }
+    for (unsigned int t = 0; !error && t < threads; t++) {
+        error = ranges[t].error;
+    }
+
+    if (output_map) {
+        munmap(output_map, size);
+    }
+    if (input_map) {
+        munmap((void*)input_map, size);
+    }
+    close(input_fd);
+    if (close(output_fd) != 0 && !error) {
+        error = errno;
+    }
+
+    // Only reached with an output confirmed to be a regular file
+    if (error) {
+        unlink(output_filename);
+        errno = error;
+        return -1;
+    }
+
+    if (bytes_processed) {
+        *bytes_processed = size;
+    }
+    return 0;
+}
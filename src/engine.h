@@ -0,0 +1,55 @@
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Tunable block-based file engine (POSIX threads, Linux only).
+//
+// Unlike encrypt_file/decrypt_file, which stream through stdio, this engine
+// lets the caller choose the block size, the number of worker threads and
+// the I/O backend. It prints nothing; on failure it returns -1 with errno set.
+// Input and output must be regular files (ESPIPE for pipes and devices); a
+// missing output is created.
+// If the input's filesystem rejects O_DIRECT or mmap, the input is read
+// through the page cache instead (ENGINE_BACKEND_READWRITE).
+
+typedef enum {
+    ENGINE_BACKEND_READWRITE = 0,   // pread/pwrite through the page cache
+    ENGINE_BACKEND_MMAP,            // shared mappings of input and output
+    ENGINE_BACKEND_DIRECT,          // O_DIRECT reads, buffered writes
+    ENGINE_BACKEND_COUNT
+} engine_backend;
+
+typedef enum {
+    ENGINE_ENCRYPT,
+    ENGINE_DECRYPT
+} engine_op;
+
+typedef struct {
+    engine_backend backend;
+    size_t block_size;      // Multiple of ENGINE_ALIGNMENT
+    unsigned int threads;
+} engine_params;
+
+#define ENGINE_ALIGNMENT 4096
+
+struct fe_progress;
+
+int engine_transform_file(const char* input_filename, const char* output_filename, int key,
+                          engine_op op, const engine_params* params, uint64_t* bytes_processed,
+                          struct fe_progress* progress);
+
+const char* engine_backend_name(engine_backend backend);
+
+int engine_backend_from_name(const char* name, engine_backend* backend);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ENGINE_H
@@ -0,0 +1,249 @@
+#ifndef FILE_ENCRYPTOR_HPP
+#define FILE_ENCRYPTOR_HPP
+
+// Header-only C++17 front end over the C core.
+//
+// fe::transform<Cipher, Key> bakes a constant key into the kernel so the
+// per-byte work is a single 8-bit add the compiler can inline and vectorize.
+// fe::runtime_transform<Cipher> takes the key at run time and forwards to the
+// C buffer kernels. Both accept contiguous byte ranges (std::vector,
+// std::array, std::string, std::span, ...) and iterator pairs.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if __cplusplus >= 202002L && __has_include(<span>)
+#include <span>
+#endif
+
+#include "encryption.h"
+#include "decryption.h"
+
+namespace fe {
+
+// Same normalization as the C core: any int maps into 0-255
+constexpr std::uint8_t normalize_key(int key) noexcept {
+    return static_cast<std::uint8_t>(((key % 256) + 256) % 256);
+}
+
+// Cipher tags. Both directions reduce to adding a shift modulo 256.
+struct caesar_encrypt {
+    static constexpr std::uint8_t shift(int key) noexcept {
+        return normalize_key(key);
+    }
+
+    static void buffer(std::uint8_t* data, std::size_t length, int key) noexcept {
+        encrypt_buffer(data, length, key);
+    }
+};
+
+struct caesar_decrypt {
+    static constexpr std::uint8_t shift(int key) noexcept {
+        return static_cast<std::uint8_t>(256 - normalize_key(key));
+    }
+
+    static void buffer(std::uint8_t* data, std::size_t length, int key) noexcept {
+        decrypt_buffer(data, length, key);
+    }
+};
+
+namespace detail {
+
+template <typename T>
+constexpr bool is_byte_like_v = sizeof(T) == 1 && (std::is_integral_v<T> || std::is_same_v<T, std::byte>);
+
+template <typename Range>
+using range_value_t = std::remove_cv_t<std::remove_pointer_t<decltype(std::data(std::declval<Range&>()))>>;
+
+template <typename Range>
+std::uint8_t* byte_data(Range& range) noexcept {
+    static_assert(is_byte_like_v<range_value_t<Range>>, "fe: range elements must be single bytes");
+    static_assert(!std::is_const_v<std::remove_pointer_t<decltype(std::data(range))>>,
+                  "fe: in-place transforms need a mutable range");
+    return reinterpret_cast<std::uint8_t*>(std::data(range));
+}
+
+} // namespace detail
+
+// Compile-time key specialization
+template <typename Cipher, int Key>
+struct transform {
+    static constexpr std::uint8_t shift = Cipher::shift(Key);
+
+    static constexpr std::uint8_t byte(std::uint8_t value) noexcept {
+        return static_cast<std::uint8_t>(value + shift);
+    }
+
+    static void apply(std::uint8_t* data, std::size_t length) noexcept {
+        for (std::size_t i = 0; i < length; i++) {
+            data[i] = static_cast<std::uint8_t>(data[i] + shift);
+        }
+    }
+
+    template <typename Range>
+    static void apply(Range& range) noexcept {
+        apply(detail::byte_data(range), std::size(range));
+    }
+
+#if __cplusplus >= 202002L && __has_include(<span>)
+    static void apply(std::span<std::uint8_t> bytes) noexcept {
+        apply(bytes.data(), bytes.size());
+    }
+#endif
+
+    template <typename InputIt, typename OutputIt>
+    static OutputIt copy(InputIt first, InputIt last, OutputIt out) {
+        static_assert(detail::is_byte_like_v<typename std::iterator_traits<InputIt>::value_type>,
+                      "fe: range elements must be single bytes");
+        for (; first != last; ++first, ++out) {
+            *out = static_cast<typename std::iterator_traits<InputIt>::value_type>(
+                byte(static_cast<std::uint8_t>(*first)));
+        }
+        return out;
+    }
+};
+
+template <int Key>
+using encrypt = transform<caesar_encrypt, Key>;
+
+template <int Key>
+using decrypt = transform<caesar_decrypt, Key>;
+
+// Run-time key, backed by the C buffer kernels
+template <typename Cipher>
+class runtime_transform {
+public:
+    explicit runtime_transform(int key) noexcept : key_(key), shift_(Cipher::shift(key)) {}
+
+    std::uint8_t byte(std::uint8_t value) const noexcept {
+        return static_cast<std::uint8_t>(value + shift_);
+    }
+
+    void apply(std::uint8_t* data, std::size_t length) const noexcept {
+        Cipher::buffer(data, length, key_);
+    }
+
+    template <typename Range>
+    void apply(Range& range) const noexcept {
+        apply(detail::byte_data(range), std::size(range));
+    }
+
+#if __cplusplus >= 202002L && __has_include(<span>)
+    void apply(std::span<std::uint8_t> bytes) const noexcept {
+        apply(bytes.data(), bytes.size());
+    }
+#endif
+
+    template <typename InputIt, typename OutputIt>
+    OutputIt copy(InputIt first, InputIt last, OutputIt out) const {
+        static_assert(detail::is_byte_like_v<typename std::iterator_traits<InputIt>::value_type>,
+                      "fe: range elements must be single bytes");
+        for (; first != last; ++first, ++out) {
+            *out = static_cast<typename std::iterator_traits<InputIt>::value_type>(
+                byte(static_cast<std::uint8_t>(*first)));
+        }
+        return out;
+    }
+
+private:
+    int key_;
+    std::uint8_t shift_;
+};
+
+// Move-only file-to-file stream. Reads fixed-size chunks, transforms them in
+// place with Kernel and writes them out. Errors follow the C core: run()
+// returns -1 and a message is printed to stderr.
+template <typename Kernel>
+class stream {
+public:
+    static constexpr std::size_t default_chunk_size = 64 * 1024;
+
+    stream(const char* input_filename, const char* output_filename, Kernel kernel = Kernel(),
+           std::size_t chunk_size = default_chunk_size)
+        : kernel_(std::move(kernel)), buffer_(chunk_size ? chunk_size : default_chunk_size) {
+        if (!input_filename || !output_filename) {
+            std::fprintf(stderr, "Error: Invalid filename parameters\n");
+            return;
+        }
+
+        input_.reset(std::fopen(input_filename, "rb"));
+        if (!input_) {
+            std::fprintf(stderr, "Error: Could not open input file '%s' for reading\n", input_filename);
+            return;
+        }
+
+        output_.reset(std::fopen(output_filename, "wb"));
+        if (!output_) {
+            std::fprintf(stderr, "Error: Could not open output file '%s' for writing\n", output_filename);
+            input_.reset();
+        }
+    }
+
+    stream(stream&&) noexcept = default;
+    stream& operator=(stream&&) noexcept = default;
+    stream(const stream&) = delete;
+    stream& operator=(const stream&) = delete;
+
+    bool is_open() const noexcept { return input_ && output_; }
+    explicit operator bool() const noexcept { return is_open(); }
+
+    std::uint64_t bytes_processed() const noexcept { return bytes_processed_; }
+
+    // Process one chunk. Returns bytes written, 0 at end of input, -1 on error.
+    long long step() {
+        if (!is_open()) {
+            return -1;
+        }
+
+        std::size_t n = std::fread(buffer_.data(), 1, buffer_.size(), input_.get());
+        if (n == 0) {
+            return std::ferror(input_.get()) ? -1 : 0;
+        }
+
+        kernel_.apply(buffer_.data(), n);
+
+        if (std::fwrite(buffer_.data(), 1, n, output_.get()) != n) {
+            std::fprintf(stderr, "Error: Failed to write to output file\n");
+            return -1;
+        }
+
+        bytes_processed_ += n;
+        return static_cast<long long>(n);
+    }
+
+    // Process to end of input and flush. Returns 0 on success, -1 on error.
+    int run() {
+        long long n;
+        while ((n = step()) > 0) {
+        }
+        if (n < 0) {
+            return -1;
+        }
+        if (std::fflush(output_.get()) != 0) {
+            std::fprintf(stderr, "Error: Failed to write to output file\n");
+            return -1;
+        }
+        return 0;
+    }
+
+private:
+    struct file_closer {
+        void operator()(std::FILE* file) const noexcept { std::fclose(file); }
+    };
+
+    Kernel kernel_;
+    std::vector<std::uint8_t> buffer_;
+    std::unique_ptr<std::FILE, file_closer> input_;
+    std::unique_ptr<std::FILE, file_closer> output_;
+    std::uint64_t bytes_processed_ = 0;
+};
+
+} // namespace fe
+
+#endif // FILE_ENCRYPTOR_HPP
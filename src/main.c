@@ -2,15 +2,27 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <errno.h>
 #include "encryption.h"
 #include "decryption.h"
+#include "dedup_cache.h"
+#include "progress.h"
+
+#ifdef __linux__
+#include "engine.h"
+#include "autotune.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#endif
 
 void display_help(const char* program_name) {
     printf("=== File Encryptor/Decryptor ===\n");
     printf("A simple Caesar cipher-based file encryption/decryption tool\n\n");
     
     printf("USAGE:\n");
-    printf("  %s <mode> <input_file> <output_file> <key>\n\n", program_name);
+    printf("  %s <mode> <input_file> <output_file> <key> [options]\n\n", program_name);
     
     printf("MODES:\n");
     printf("  -e, --encrypt    Encrypt the input file\n");
@@ -22,6 +34,19 @@ void display_help(const char* program_name) {
     printf("  output_file      Path to the output file to create\n");
     printf("  key              Integer key for encryption/decryption (0-255)\n\n");
     
+    printf("OPTIONS:\n");
+    printf("  --cache-dir <dir>  Reuse outputs of identical inputs from a dedup cache\n");
+#ifdef __linux__
+    printf("  --autotune         Calibrate block size, threads and I/O backend for the\n");
+    printf("                     output's filesystem and remember the result\n");
+    printf("  --progress         Report percent, rate and ETA on stderr\n");
+    printf("  --progress-json <file|fd:N>\n");
+    printf("                     Append periodic JSON progress lines to a file or fd\n");
+    printf("  --progress-interval <ms>\n");
+    printf("                     Progress sampling interval (default 1000)\n");
+#endif
+    printf("\n");
+    
     printf("EXAMPLES:\n");
     printf("  # Encrypt a file with key 42\n");
     printf("  %s --encrypt document.txt encrypted.bin 42\n\n", program_name);
@@ -29,6 +54,17 @@ void display_help(const char* program_name) {
     printf("  # Decrypt the encrypted file\n");
     printf("  %s --decrypt encrypted.bin decrypted.txt 42\n\n", program_name);
     
+    printf("  # Skip re-encrypting files already processed with the same key\n");
+    printf("  %s --encrypt backup.tar backup.bin 42 --cache-dir .fe-cache\n\n", program_name);
+    
+#ifdef __linux__
+    printf("  # Calibrate once per filesystem; later runs reuse the stored profile\n");
+    printf("  %s --encrypt video.mp4 video.bin 42 --autotune\n\n", program_name);
+    
+    printf("  # Watch a long run and feed a monitoring agent on fd 3\n");
+    printf("  %s --encrypt disk.img disk.bin 42 --progress --progress-json fd:3\n\n", program_name);
+    
+#endif
     printf("  # Display help\n");
     printf("  %s --help\n\n", program_name);
     
@@ -36,9 +72,33 @@ void display_help(const char* program_name) {
     printf("  - The same key must be used for both encryption and decryption\n");
     printf("  - Input and output files can be text or binary files\n");
     printf("  - The program uses Caesar cipher with byte-level operations\n");
-    printf("  - Key values outside 0-255 will be normalized automatically\n\n");
+    printf("  - Key values outside 0-255 will be normalized automatically\n");
+#ifdef __linux__
+    printf("  - Tuning profiles are not applied together with --cache-dir\n");
+#endif
+    printf("\n");
 }
 
+#ifdef __linux__
+// Run the tuned engine with the same console output as encrypt_file/decrypt_file
+static int tuned_transform_file(const char* input_file, const char* output_file, int key,
+                                engine_op op, const engine_params* params, fe_progress* progress) {
+    const char* verb = (op == ENGINE_ENCRYPT) ? "Encrypting" : "Decrypting";
+    const char* noun = (op == ENGINE_ENCRYPT) ? "Encryption" : "Decryption";
+    
+    printf("%s file '%s' to '%s' with key %d...\n", verb, input_file, output_file, key);
+    
+    uint64_t bytes_processed = 0;
+    if (engine_transform_file(input_file, output_file, key, op, params, &bytes_processed, progress) != 0) {
+        fprintf(stderr, "Error: %s of '%s' failed: %s\n", noun, input_file, strerror(errno));
+        return -1;
+    }
+    
+    printf("%s completed successfully. Processed %llu bytes.\n", noun, (unsigned long long)bytes_processed);
+    return 0;
+}
+#endif
+
 bool is_valid_integer(const char* str) {
     if (!str || *str == '\0') {
         return false;
@@ -63,6 +123,24 @@ bool is_valid_integer(const char* str) {
     return true;
 }
 
+#ifdef __linux__
+// Open the --progress-json target: "fd:N" names an inherited descriptor
+static int open_progress_target(const char* target, bool* owned) {
+    *owned = false;
+    
+    if (strncmp(target, "fd:", 3) == 0) {
+        if (!is_valid_integer(target + 3) || target[3] == '-') {
+            return -1;
+        }
+        int fd = atoi(target + 3);
+        return fcntl(fd, F_GETFD) == -1 ? -1 : fd;
+    }
+    
+    *owned = true;
+    return open(target, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+}
+#endif
+
 int main(int argc, char* argv[]) {
     // Check for minimum number of arguments
     if (argc < 2) {
@@ -78,9 +156,9 @@ int main(int argc, char* argv[]) {
     }
     
     // Check for correct number of arguments for encrypt/decrypt operations
-    if (argc != 5) {
+    if (argc < 5) {
         fprintf(stderr, "Error: Invalid number of arguments\n");
-        fprintf(stderr, "Expected: %s <mode> <input_file> <output_file> <key>\n", argv[0]);
+        fprintf(stderr, "Expected: %s <mode> <input_file> <output_file> <key> [options]\n", argv[0]);
         fprintf(stderr, "Use '%s --help' for detailed usage information\n", argv[0]);
         return 1;
     }
@@ -99,6 +177,45 @@ int main(int argc, char* argv[]) {
     
     int key = atoi(key_str);
     
+    // Parse trailing options
+    const char* cache_dir = NULL;
+    bool autotune = false;
+    bool show_progress = false;
+    const char* progress_json = NULL;
+    unsigned int progress_interval_ms = 1000;
+    
+    for (int i = 5; i < argc; i++) {
+        if (strcmp(argv[i], "--cache-dir") == 0) {
+            if (i + 1 >= argc || strlen(argv[i + 1]) == 0) {
+                fprintf(stderr, "Error: --cache-dir requires a directory argument\n");
+                return 1;
+            }
+            cache_dir = argv[++i];
+#ifdef __linux__
+        } else if (strcmp(argv[i], "--autotune") == 0) {
+            autotune = true;
+        } else if (strcmp(argv[i], "--progress") == 0) {
+            show_progress = true;
+        } else if (strcmp(argv[i], "--progress-json") == 0) {
+            if (i + 1 >= argc || strlen(argv[i + 1]) == 0) {
+                fprintf(stderr, "Error: --progress-json requires a file or fd:N argument\n");
+                return 1;
+            }
+            progress_json = argv[++i];
+        } else if (strcmp(argv[i], "--progress-interval") == 0) {
+            if (i + 1 >= argc || !is_valid_integer(argv[i + 1]) || atoi(argv[i + 1]) <= 0) {
+                fprintf(stderr, "Error: --progress-interval requires a positive number of milliseconds\n");
+                return 1;
+            }
+            progress_interval_ms = (unsigned int)atoi(argv[++i]);
+#endif
+        } else {
+            fprintf(stderr, "Error: Unknown option '%s'\n", argv[i]);
+            fprintf(stderr, "Use '%s --help' for detailed usage information\n", argv[0]);
+            return 1;
+        }
+    }
+    
     // Validate file names
     if (strlen(input_file) == 0) {
         fprintf(stderr, "Error: Input filename cannot be empty\n");
@@ -116,31 +233,156 @@ int main(int argc, char* argv[]) {
         return 1;
     }
     
+    // Validate mode before doing any work
+    bool encrypting = strcmp(mode, "-e") == 0 || strcmp(mode, "--encrypt") == 0;
+    bool decrypting = strcmp(mode, "-d") == 0 || strcmp(mode, "--decrypt") == 0;
+    
+    if (!encrypting && !decrypting) {
+        fprintf(stderr, "Error: Invalid mode '%s'\n", mode);
+        fprintf(stderr, "Valid modes: -e, --encrypt, -d, --decrypt, -h, --help\n");
+        fprintf(stderr, "Use '%s --help' for detailed usage information\n", argv[0]);
+        return 1;
+    }
+    
+    // Choose engine parameters for the output's filesystem
+#ifdef __linux__
+    const char* tuning_source = NULL;
+    tune_profile tuning;
+    char probe_dir[4096];
+    dev_t device;
+    struct stat input_stat;
+    struct stat output_stat;
+    bool input_regular = stat(input_file, &input_stat) == 0 && S_ISREG(input_stat.st_mode);
+    bool output_regular = stat(output_file, &output_stat) != 0 ? errno == ENOENT : S_ISREG(output_stat.st_mode);
+    
+    if (cache_dir) {
+        if (autotune) {
+            fprintf(stderr, "Warning: --autotune is ignored together with --cache-dir\n");
+        }
+    } else if (!input_regular || !output_regular) {
+        // The tuned engine needs seekable files; stream pipes and devices through stdio
+        if (autotune) {
+            fprintf(stderr, "Warning: --autotune needs regular input and output files; using the default engine\n");
+        }
+    } else if (autotune_target(output_file, probe_dir, sizeof(probe_dir), &device) == 0) {
+        if (autotune) {
+            printf("Calibrating I/O parameters in '%s'...\n", probe_dir);
+            if (autotune_calibrate(probe_dir, &tuning) == 0) {
+                tuning_source = "calibrated";
+                if (autotune_save(device, &tuning) != 0) {
+                    fprintf(stderr, "Warning: Could not save tuning profile '%s'\n",
+                            autotune_profile_path() ? autotune_profile_path() : "(no cache directory)");
+                }
+            } else {
+                fprintf(stderr, "Warning: Calibration failed; using the default engine\n");
+            }
+        } else if (autotune_load(device, &tuning) == 0) {
+            tuning_source = "profile";
+        }
+    } else if (autotune) {
+        fprintf(stderr, "Warning: Cannot determine the output filesystem; using the default engine\n");
+    }
+#else
+    (void)autotune;
+    (void)show_progress;
+    (void)progress_json;
+    (void)progress_interval_ms;
+#endif
+    
+    // Start the progress reporter; the transform only bumps a relaxed counter
+    fe_progress* progress_counter = NULL;
+#ifdef __linux__
+    fe_progress progress = {0};
+    progress_reporter* reporter = NULL;
+    int json_fd = -1;
+    bool json_fd_owned = false;
+    
+    if (progress_json) {
+        json_fd = open_progress_target(progress_json, &json_fd_owned);
+        if (json_fd < 0) {
+            fprintf(stderr, "Error: Could not open progress target '%s'\n", progress_json);
+            return 1;
+        }
+    }
+    
+    if (show_progress || json_fd >= 0) {
+        uint64_t bytes_total = input_regular ? (uint64_t)input_stat.st_size : FE_PROGRESS_TOTAL_UNKNOWN;
+        
+        reporter = progress_reporter_start(&progress, bytes_total, show_progress ? stderr : NULL,
+                                           json_fd, progress_interval_ms);
+        if (reporter) {
+            progress_counter = &progress;
+        } else {
+            fprintf(stderr, "Warning: Could not start progress reporting\n");
+        }
+    }
+#endif
+    
     // Process based on mode
     int result = -1;
+    dedup_stats cache_stats = {0};
     
-    if (strcmp(mode, "-e") == 0 || strcmp(mode, "--encrypt") == 0) {
+    if (encrypting) {
         printf("Mode: Encryption\n");
         printf("Input file: %s\n", input_file);
         printf("Output file: %s\n", output_file);
         printf("Key: %d\n\n", key);
         
-        result = encrypt_file(input_file, output_file, key);
+        if (cache_dir) {
+            result = cached_transform_file(cache_dir, input_file, output_file, key, CACHE_MODE_ENCRYPT, &cache_stats,
+                                           progress_counter);
+#ifdef __linux__
+        } else if (tuning_source) {
+            result = tuned_transform_file(input_file, output_file, key, ENGINE_ENCRYPT, &tuning.params, progress_counter);
+#endif
+        } else {
+            result = encrypt_file_with_progress(input_file, output_file, key, progress_counter);
+        }
         
-    } else if (strcmp(mode, "-d") == 0 || strcmp(mode, "--decrypt") == 0) {
+    } else {
         printf("Mode: Decryption\n");
         printf("Input file: %s\n", input_file);
         printf("Output file: %s\n", output_file);
         printf("Key: %d\n\n", key);
         
-        result = decrypt_file(input_file, output_file, key);
-        
-    } else {
-        fprintf(stderr, "Error: Invalid mode '%s'\n", mode);
-        fprintf(stderr, "Valid modes: -e, --encrypt, -d, --decrypt, -h, --help\n");
-        fprintf(stderr, "Use '%s --help' for detailed usage information\n", argv[0]);
-        return 1;
+        if (cache_dir) {
+            result = cached_transform_file(cache_dir, input_file, output_file, key, CACHE_MODE_DECRYPT, &cache_stats,
+                                           progress_counter);
+#ifdef __linux__
+        } else if (tuning_source) {
+            result = tuned_transform_file(input_file, output_file, key, ENGINE_DECRYPT, &tuning.params, progress_counter);
+#endif
+        } else {
+            result = decrypt_file_with_progress(input_file, output_file, key, progress_counter);
+        }
+    }
+    
+#ifdef __linux__
+    // Stop the reporter; it prints a final sample with the average rate
+    progress_reporter_stop(reporter);
+    if (json_fd_owned) {
+        close(json_fd);
+    }
+#endif
+    
+    // Report cache statistics
+    if (cache_dir) {
+        printf("Cache: %zu hit(s), %zu miss(es), %llu bytes reused",
+               cache_stats.hits, cache_stats.misses, (unsigned long long)cache_stats.bytes_reused);
+        if (cache_stats.hits > 0) {
+            printf(" (%s)", cache_link_method_name(cache_stats.last_method));
+        }
+        printf("\n");
+    }
+    
+#ifdef __linux__
+    // Report tuning decisions
+    if (tuning_source) {
+        printf("Tuning: backend=%s block=%zu threads=%u (%s, %.1f MB/s at calibration)\n",
+               engine_backend_name(tuning.params.backend), tuning.params.block_size,
+               tuning.params.threads, tuning_source, tuning.mbps);
     }
+#endif
     
     // Check operation result
     if (result == 0) {
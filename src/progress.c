@@ -0,0 +1,217 @@
+#include "progress.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+struct progress_reporter {
+    fe_progress* progress;
+    uint64_t bytes_total;
+    FILE* human_output;
+    bool human_is_tty;
+    int json_fd;
+    unsigned int interval_ms;
+
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    bool stopping;
+
+    double start_time;
+    double last_time;
+    uint64_t last_bytes;
+};
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static void format_bytes(char* text, size_t size, double bytes) {
+    const char* units[] = {"B", "KiB", "MiB", "GiB", "TiB"};
+    int unit = 0;
+    while (bytes >= 1024.0 && unit < 4) {
+        bytes /= 1024.0;
+        unit++;
+    }
+    snprintf(text, size, unit == 0 ? "%.0f %s" : "%.1f %s", bytes, units[unit]);
+}
+
+static void format_eta(char* text, size_t size, double seconds) {
+    if (seconds < 0) {
+        snprintf(text, size, "--:--:--");
+        return;
+    }
+    unsigned long long total = (unsigned long long)(seconds + 0.5);
+    snprintf(text, size, "%02llu:%02llu:%02llu", total / 3600, (total / 60) % 60, total % 60);
+}
+
+// Emit one sample. Called only from the reporter thread (and once on stop).
+static void report_sample(progress_reporter* reporter, bool final) {
+    double now = now_seconds();
+    uint64_t done = atomic_load_explicit(&reporter->progress->bytes_done, memory_order_relaxed);
+
+    // Rate over the last interval, so a stalled transform shows up as 0 B/s
+    double window = now - reporter->last_time;
+    double rate = window > 0 ? (double)(done - reporter->last_bytes) / window : 0.0;
+    double elapsed = now - reporter->start_time;
+    if (final) {
+        rate = elapsed > 0 ? (double)done / elapsed : 0.0;
+    }
+    reporter->last_time = now;
+    reporter->last_bytes = done;
+
+    // Without a known total there is nothing to measure completion against
+    bool known_total = reporter->bytes_total != FE_PROGRESS_TOTAL_UNKNOWN;
+    double percent = 100.0;
+    double eta = -1.0;
+    if (known_total) {
+        if (reporter->bytes_total > 0) {
+            percent = 100.0 * (double)done / (double)reporter->bytes_total;
+        }
+        if (done >= reporter->bytes_total) {
+            eta = 0.0;
+        } else if (rate > 0) {
+            eta = (double)(reporter->bytes_total - done) / rate;
+        }
+    }
+
+    if (reporter->human_output) {
+        char percent_text[16], done_text[32], total_text[32], rate_text[32], eta_text[32];
+        format_bytes(done_text, sizeof(done_text), (double)done);
+        format_bytes(rate_text, sizeof(rate_text), rate);
+        format_eta(eta_text, sizeof(eta_text), eta);
+        if (known_total) {
+            snprintf(percent_text, sizeof(percent_text), "%5.1f%%", percent);
+            format_bytes(total_text, sizeof(total_text), (double)reporter->bytes_total);
+        } else {
+            snprintf(percent_text, sizeof(percent_text), "   --");
+            snprintf(total_text, sizeof(total_text), "--");
+        }
+
+        // Redraw in place on a terminal; one line per sample otherwise (logs)
+        fprintf(reporter->human_output, "%sProgress: %s  %s / %s  %s/s  ETA %s%s",
+                reporter->human_is_tty ? "\r" : "", percent_text, done_text, total_text,
+                rate_text, eta_text, (reporter->human_is_tty && !final) ? "   " : "\n");
+        fflush(reporter->human_output);
+    }
+
+    if (reporter->json_fd >= 0) {
+        // Unknown quantities are null rather than a misleading number
+        char total_json[32] = "null", percent_json[32] = "null", eta_json[32] = "null";
+        if (known_total) {
+            snprintf(total_json, sizeof(total_json), "%llu", (unsigned long long)reporter->bytes_total);
+            snprintf(percent_json, sizeof(percent_json), "%.2f", percent);
+        }
+        if (eta >= 0) {
+            snprintf(eta_json, sizeof(eta_json), "%.1f", eta);
+        }
+
+        char line[256];
+        int length = snprintf(line, sizeof(line),
+                              "{\"bytes_done\":%llu,\"bytes_total\":%s,\"percent\":%s,"
+                              "\"rate_bytes_per_sec\":%.0f,\"eta_sec\":%s,\"elapsed_sec\":%.3f,\"final\":%s}\n",
+                              (unsigned long long)done, total_json, percent_json,
+                              rate, eta_json, elapsed, final ? "true" : "false");
+
+        // A single write per line keeps lines intact on pipes shared with other writers
+        if (length > 0 && (size_t)length < sizeof(line)) {
+            ssize_t ignored = write(reporter->json_fd, line, (size_t)length);
+            (void)ignored;
+        }
+    }
+}
+
+static void* reporter_main(void* arg) {
+    progress_reporter* reporter = arg;
+
+    pthread_mutex_lock(&reporter->lock);
+    while (!reporter->stopping) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+        deadline.tv_sec += reporter->interval_ms / 1000;
+        deadline.tv_nsec += (long)(reporter->interval_ms % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+
+        int wait = 0;
+        while (!reporter->stopping && wait != ETIMEDOUT) {
+            wait = pthread_cond_timedwait(&reporter->wake, &reporter->lock, &deadline);
+        }
+
+        if (!reporter->stopping) {
+            report_sample(reporter, false);
+        }
+    }
+    pthread_mutex_unlock(&reporter->lock);
+
+    return NULL;
+}
+
+progress_reporter* progress_reporter_start(fe_progress* progress, uint64_t bytes_total,
+                                           FILE* human_output, int json_fd, unsigned int interval_ms) {
+    if (!progress || (!human_output && json_fd < 0)) {
+        return NULL;
+    }
+
+    progress_reporter* reporter = calloc(1, sizeof(*reporter));
+    if (!reporter) {
+        return NULL;
+    }
+
+    reporter->progress = progress;
+    reporter->bytes_total = bytes_total;
+    reporter->human_output = human_output;
+    reporter->human_is_tty = human_output && isatty(fileno(human_output));
+    reporter->json_fd = json_fd;
+    reporter->interval_ms = interval_ms ? interval_ms : 1000;
+    reporter->start_time = now_seconds();
+    reporter->last_time = reporter->start_time;
+    reporter->last_bytes = atomic_load_explicit(&progress->bytes_done, memory_order_relaxed);
+
+    pthread_mutex_init(&reporter->lock, NULL);
+
+    // Wait on the monotonic clock so wall-clock jumps neither stall nor
+    // flood the samples; the deadline in reporter_main uses the same clock
+    pthread_condattr_t wake_attr;
+    pthread_condattr_init(&wake_attr);
+    pthread_condattr_setclock(&wake_attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&reporter->wake, &wake_attr);
+    pthread_condattr_destroy(&wake_attr);
+
+    if (pthread_create(&reporter->thread, NULL, reporter_main, reporter) != 0) {
+        pthread_cond_destroy(&reporter->wake);
+        pthread_mutex_destroy(&reporter->lock);
+        free(reporter);
+        return NULL;
+    }
+
+    return reporter;
+}
+
+void progress_reporter_stop(progress_reporter* reporter) {
+    if (!reporter) {
+        return;
+    }
+
+    pthread_mutex_lock(&reporter->lock);
+    reporter->stopping = true;
+    pthread_cond_signal(&reporter->wake);
+    pthread_mutex_unlock(&reporter->lock);
+
+    pthread_join(reporter->thread, NULL);
+
+    // Final sample reports the overall average rate
+    report_sample(reporter, true);
+
+    pthread_cond_destroy(&reporter->wake);
+    pthread_mutex_destroy(&reporter->lock);
+    free(reporter);
+}
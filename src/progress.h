@@ -0,0 +1,47 @@
+#ifndef PROGRESS_H
+#define PROGRESS_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdatomic.h>
+
+// Byte counter shared between a transform and a progress reporter.
+//
+// Transform loops only touch the counter with relaxed atomics (no locks, no
+// syscalls); a separate reporter thread samples it at a fixed interval.
+
+typedef struct fe_progress {
+    _Atomic uint64_t bytes_done;
+} fe_progress;
+
+// Single-writer loops publish their running total at most this often
+#define FE_PROGRESS_STRIDE (64 * 1024)
+
+// Publish a running total (one writer per counter)
+static inline void progress_publish(fe_progress* progress, uint64_t bytes_done) {
+    if (progress) {
+        atomic_store_explicit(&progress->bytes_done, bytes_done, memory_order_relaxed);
+    }
+}
+
+// Add to the counter (several writers per counter)
+static inline void progress_add(fe_progress* progress, uint64_t bytes) {
+    if (progress) {
+        atomic_fetch_add_explicit(&progress->bytes_done, bytes, memory_order_relaxed);
+    }
+}
+
+#ifdef __linux__
+typedef struct progress_reporter progress_reporter;
+
+// bytes_total for inputs whose size is not known up front (pipes, devices);
+// samples then carry bytes and rate but no percent or ETA
+#define FE_PROGRESS_TOTAL_UNKNOWN UINT64_MAX
+
+progress_reporter* progress_reporter_start(fe_progress* progress, uint64_t bytes_total,
+                                           FILE* human_output, int json_fd, unsigned int interval_ms);
+
+void progress_reporter_stop(progress_reporter* reporter);
+#endif
+
+#endif // PROGRESS_H
@@ -0,0 +1,24 @@
+#ifndef SHA256_H
+#define SHA256_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// SHA-256 (FIPS 180-4), used to address dedup cache entries
+
+#define SHA256_DIGEST_SIZE 32
+
+typedef struct {
+    uint32_t state[8];
+    uint64_t length;        // Total bytes hashed
+    uint8_t block[64];
+    size_t block_used;
+} sha256_ctx;
+
+void sha256_init(sha256_ctx* ctx);
+
+void sha256_update(sha256_ctx* ctx, const uint8_t* data, size_t length);
+
+void sha256_final(sha256_ctx* ctx, uint8_t digest[SHA256_DIGEST_SIZE]);
+
+#endif // SHA256_H
@@ -0,0 +1,231 @@
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+#include <unistd.h>
+#include "file_encryptor.hpp"
+
+// cmocka.h defines a fail() macro, so it comes after the standard headers
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+namespace {
+
+constexpr int test_key = 300;   // Normalizes to 44
+constexpr int negative_key = -7;
+
+std::vector<std::uint8_t> all_bytes() {
+    std::vector<std::uint8_t> data(1000);
+    for (std::size_t i = 0; i < data.size(); i++) {
+        data[i] = static_cast<std::uint8_t>(i * 37 + (i >> 8));
+    }
+    return data;
+}
+
+void write_file(const char* filename, const std::vector<std::uint8_t>& data) {
+    std::FILE* file = std::fopen(filename, "wb");
+    assert_non_null(file);
+    assert_int_equal(std::fwrite(data.data(), 1, data.size(), file), data.size());
+    std::fclose(file);
+}
+
+std::vector<std::uint8_t> read_file(const char* filename) {
+    std::vector<std::uint8_t> data;
+    std::FILE* file = std::fopen(filename, "rb");
+    assert_non_null(file);
+    int c;
+    while ((c = std::fgetc(file)) != EOF) {
+        data.push_back(static_cast<std::uint8_t>(c));
+    }
+    std::fclose(file);
+    return data;
+}
+
+void assert_encrypted(const std::vector<std::uint8_t>& result, const std::vector<std::uint8_t>& source, int key) {
+    assert_int_equal(result.size(), source.size());
+    for (std::size_t i = 0; i < source.size(); i++) {
+        assert_int_equal(result[i], encrypt_byte(source[i], key));
+    }
+}
+
+void assert_decrypted(const std::vector<std::uint8_t>& result, const std::vector<std::uint8_t>& source, int key) {
+    assert_int_equal(result.size(), source.size());
+    for (std::size_t i = 0; i < source.size(); i++) {
+        assert_int_equal(result[i], decrypt_byte(source[i], key));
+    }
+}
+
+} // namespace
+
+// Compile-time kernels match the C byte functions in both directions
+static void test_static_transform(void **state) {
+    (void)state;
+
+    static_assert(fe::encrypt<test_key>::byte(0) == 44, "constant key folds at compile time");
+    static_assert(fe::decrypt<test_key>::byte(44) == 0, "decrypt inverts encrypt");
+
+    const std::vector<std::uint8_t> source = all_bytes();
+
+    // Pointer and length
+    std::vector<std::uint8_t> data = source;
+    fe::encrypt<test_key>::apply(data.data(), data.size());
+    assert_encrypted(data, source, test_key);
+    fe::decrypt<test_key>::apply(data.data(), data.size());
+    assert_memory_equal(data.data(), source.data(), source.size());
+
+    // Contiguous ranges
+    data = source;
+    fe::encrypt<negative_key>::apply(data);
+    assert_encrypted(data, source, negative_key);
+    data = source;
+    fe::decrypt<negative_key>::apply(data);
+    assert_decrypted(data, source, negative_key);
+
+    const std::array<std::uint8_t, 4> edges = {0, 1, 254, 255};
+    std::array<std::uint8_t, 4> fixed = edges;
+    fe::encrypt<test_key>::apply(fixed);
+    for (std::size_t i = 0; i < fixed.size(); i++) {
+        assert_int_equal(fixed[i], encrypt_byte(edges[i], test_key));
+    }
+
+    std::string text = "Hello, C++";
+    fe::encrypt<test_key>::apply(text);
+    fe::decrypt<test_key>::apply(text);
+    assert_string_equal(text.c_str(), "Hello, C++");
+
+    // Iterator pairs into a separate output
+    std::vector<std::uint8_t> encrypted;
+    fe::encrypt<test_key>::copy(source.begin(), source.end(), std::back_inserter(encrypted));
+    assert_encrypted(encrypted, source, test_key);
+
+    std::vector<std::uint8_t> decrypted(source.size());
+    auto end = fe::decrypt<test_key>::copy(encrypted.begin(), encrypted.end(), decrypted.begin());
+    assert_true(end == decrypted.end());
+    assert_memory_equal(decrypted.data(), source.data(), source.size());
+
+#if __cplusplus >= 202002L && __has_include(<span>)
+    // std::span overload
+    data = source;
+    fe::encrypt<test_key>::apply(std::span<std::uint8_t>(data));
+    assert_encrypted(data, source, test_key);
+    fe::decrypt<test_key>::apply(std::span<std::uint8_t>(data).subspan(0, 10));
+    assert_memory_equal(data.data(), source.data(), 10);
+#endif
+}
+
+// Run-time kernels forward to encrypt_buffer/decrypt_buffer
+static void test_runtime_transform(void **state) {
+    (void)state;
+
+    const std::vector<std::uint8_t> source = all_bytes();
+    const int keys[] = {0, 1, 42, 255, 256, 1000, -1, -300};
+
+    for (int key : keys) {
+        fe::runtime_transform<fe::caesar_encrypt> encryptor(key);
+        fe::runtime_transform<fe::caesar_decrypt> decryptor(key);
+
+        for (std::size_t i = 0; i < 256; i++) {
+            std::uint8_t value = static_cast<std::uint8_t>(i);
+            assert_int_equal(encryptor.byte(value), encrypt_byte(value, key));
+            assert_int_equal(decryptor.byte(value), decrypt_byte(value, key));
+        }
+
+        std::vector<std::uint8_t> data = source;
+        encryptor.apply(data);
+        assert_encrypted(data, source, key);
+        decryptor.apply(data.data(), data.size());
+        assert_memory_equal(data.data(), source.data(), source.size());
+
+        std::vector<std::uint8_t> copied;
+        decryptor.copy(source.begin(), source.end(), std::back_inserter(copied));
+        assert_decrypted(copied, source, key);
+        copied.clear();
+        encryptor.copy(source.begin(), source.end(), std::back_inserter(copied));
+        assert_encrypted(copied, source, key);
+
+#if __cplusplus >= 202002L && __has_include(<span>)
+        // std::span overload
+        data = source;
+        encryptor.apply(std::span<std::uint8_t>(data));
+        assert_encrypted(data, source, key);
+        decryptor.apply(std::span<std::uint8_t>(data).subspan(0, 10));
+        assert_memory_equal(data.data(), source.data(), 10);
+#endif
+    }
+}
+
+// Streams round-trip files, including after being moved
+static void test_stream_round_trip(void **state) {
+    (void)state;
+
+    const char* input_file = "test_cpp_input.bin";
+    const char* encrypted_file = "test_cpp_encrypted.bin";
+    const char* decrypted_file = "test_cpp_decrypted.bin";
+
+    // Larger than one chunk and not a multiple of it
+    std::vector<std::uint8_t> source;
+    for (int r = 0; r < 150; r++) {
+        std::vector<std::uint8_t> block = all_bytes();
+        source.insert(source.end(), block.begin(), block.end());
+    }
+    write_file(input_file, source);
+
+    // Compile-time kernel, moved before running
+    {
+        fe::stream<fe::encrypt<test_key>> original(input_file, encrypted_file, {}, 4096);
+        assert_true(original.is_open());
+
+        fe::stream<fe::encrypt<test_key>> moved(std::move(original));
+        assert_true(static_cast<bool>(moved));
+        assert_int_equal(moved.run(), 0);
+        assert_int_equal(moved.bytes_processed(), source.size());
+    }
+    assert_encrypted(read_file(encrypted_file), source, test_key);
+
+    // Run-time kernel, step once, then move-assign and finish
+    {
+        fe::stream<fe::runtime_transform<fe::caesar_decrypt>> first(
+            encrypted_file, decrypted_file, fe::runtime_transform<fe::caesar_decrypt>(test_key), 4096);
+        assert_int_equal(first.step(), 4096);
+
+        fe::stream<fe::runtime_transform<fe::caesar_decrypt>> second(
+            "nonexistent_cpp_input.bin", "test_cpp_unused.bin", fe::runtime_transform<fe::caesar_decrypt>(0));
+        assert_false(second.is_open());
+        assert_int_equal(second.run(), -1);
+
+        second = std::move(first);
+        assert_true(second.is_open());
+        assert_int_equal(second.run(), 0);
+        assert_int_equal(second.bytes_processed(), source.size());
+    }
+    std::vector<std::uint8_t> decrypted = read_file(decrypted_file);
+    assert_int_equal(decrypted.size(), source.size());
+    assert_memory_equal(decrypted.data(), source.data(), source.size());
+
+    // Invalid arguments report an error instead of opening
+    fe::stream<fe::decrypt<test_key>> invalid(nullptr, decrypted_file);
+    assert_false(invalid.is_open());
+    assert_int_equal(invalid.step(), -1);
+
+    // Cleanup
+    unlink(input_file);
+    unlink(encrypted_file);
+    unlink(decrypted_file);
+    unlink("test_cpp_unused.bin");
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_static_transform),
+        cmocka_unit_test(test_runtime_transform),
+        cmocka_unit_test(test_stream_round_trip),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}
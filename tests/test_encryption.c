@@ -6,8 +6,21 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <errno.h>
+#include <dirent.h>
+#include <sys/stat.h>
 #include "encryption.h"
 #include "decryption.h"
+#include "dedup_cache.h"
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <poll.h>
+#include "async_jobs.h"
+#include "engine.h"
+#include "autotune.h"
+#include "progress.h"
+#endif
 
 // Test byte-level encryption/decryption
 static void test_byte_encryption_basic(void **state) {
@@ -64,6 +77,37 @@ static void test_byte_encryption_large_key(void **state) {
     assert_int_equal(decrypted, original);
 }
 
+// Test buffer kernels against the byte-level reference
+static void test_buffer_encryption_matches_bytes(void **state) {
+    (void)state;
+    
+    int keys[] = {0, 1, 42, 255, 256, -1, -300, 1000};
+    uint8_t original[256];
+    uint8_t buffer[256];
+    
+    for (size_t i = 0; i < sizeof(original); i++) {
+        original[i] = (uint8_t)i;
+    }
+    
+    for (size_t k = 0; k < sizeof(keys) / sizeof(keys[0]); k++) {
+        memcpy(buffer, original, sizeof(buffer));
+        
+        encrypt_buffer(buffer, sizeof(buffer), keys[k]);
+        for (size_t i = 0; i < sizeof(buffer); i++) {
+            assert_int_equal(buffer[i], encrypt_byte(original[i], keys[k]));
+        }
+        
+        decrypt_buffer(buffer, sizeof(buffer), keys[k]);
+        assert_memory_equal(buffer, original, sizeof(buffer));
+    }
+    
+    // NULL and empty buffers are no-ops
+    encrypt_buffer(NULL, 10, 42);
+    decrypt_buffer(NULL, 10, 42);
+    encrypt_buffer(buffer, 0, 42);
+    assert_memory_equal(buffer, original, sizeof(buffer));
+}
+
 // Helper function to create test files
 static void create_test_file(const char* filename, const char* content, size_t size) {
     FILE* file = fopen(filename, "wb");
@@ -474,12 +518,770 @@ static void test_video_like_file_encryption(void **state) {
     unlink(decrypted_file);
 }
 
+// Helper function to remove a dedup cache directory (<dir>/<size>/<entry>)
+static void remove_cache_dir(const char* dirname) {
+    DIR* dir = opendir(dirname);
+    if (!dir) {
+        return;
+    }
+    
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+            continue;
+        }
+        
+        char path[1024];
+        snprintf(path, sizeof(path), "%s/%s", dirname, entry->d_name);
+        
+        struct stat st;
+        if (stat(path, &st) == 0 && S_ISDIR(st.st_mode)) {
+            remove_cache_dir(path);
+        } else {
+            unlink(path);
+        }
+    }
+    
+    closedir(dir);
+    rmdir(dirname);
+}
+
+// Test the cache digest against FIPS 180-4 test vectors
+static void test_dedup_hash_vectors(void **state) {
+    (void)state;
+    
+    const char* hash_file = "test_dedup_hash.bin";
+    const char* inputs[] = {
+        "",
+        "abc",
+        "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq"
+    };
+    const char* expected[] = {
+        "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855",
+        "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad",
+        "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1"
+    };
+    
+    for (size_t t = 0; t < sizeof(inputs) / sizeof(inputs[0]); t++) {
+        create_test_file(hash_file, inputs[t], strlen(inputs[t]));
+        
+        uint8_t digest[SHA256_DIGEST_SIZE];
+        char hex[SHA256_DIGEST_SIZE * 2 + 1];
+        assert_int_equal(dedup_hash_file(hash_file, digest), 0);
+        for (int i = 0; i < SHA256_DIGEST_SIZE; i++) {
+            snprintf(hex + i * 2, 3, "%02x", digest[i]);
+        }
+        assert_string_equal(hex, expected[t]);
+    }
+    
+    // One million 'a' characters, spanning many read chunks
+    size_t million = 1000000;
+    char* data = malloc(million);
+    assert_non_null(data);
+    memset(data, 'a', million);
+    create_test_file(hash_file, data, million);
+    
+    uint8_t digest[SHA256_DIGEST_SIZE];
+    char hex[SHA256_DIGEST_SIZE * 2 + 1];
+    assert_int_equal(dedup_hash_file(hash_file, digest), 0);
+    for (int i = 0; i < SHA256_DIGEST_SIZE; i++) {
+        snprintf(hex + i * 2, 3, "%02x", digest[i]);
+    }
+    assert_string_equal(hex, "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0");
+    
+    assert_int_equal(dedup_hash_file("nonexistent_hash_input.bin", digest), -1);
+    
+    // Cleanup
+    free(data);
+    unlink(hash_file);
+}
+
+// Test that identical content is served from the dedup cache
+static void test_dedup_cache_hit(void **state) {
+    (void)state;
+    
+    const char* cache_dir = "test_dedup_cache";
+    const char* first_input = "test_dedup_first.bin";
+    const char* second_input = "test_dedup_second.bin";
+    const char* first_output = "test_dedup_first_encrypted.bin";
+    const char* second_output = "test_dedup_second_encrypted.bin";
+    int key = 77;
+    size_t file_size = 5000;
+    
+    char* data = malloc(file_size);
+    assert_non_null(data);
+    for (size_t i = 0; i < file_size; i++) {
+        data[i] = (char)((i * 7) % 256);
+    }
+    
+    create_test_file(first_input, data, file_size);
+    create_test_file(second_input, data, file_size);
+    
+    dedup_stats stats = {0};
+    
+    // First run populates the cache
+    int result = cached_transform_file(cache_dir, first_input, first_output, key, CACHE_MODE_ENCRYPT, &stats, NULL);
+    assert_int_equal(result, 0);
+    assert_int_equal(stats.hits, 0);
+    assert_int_equal(stats.misses, 1);
+    
+    // Identical content under a different name is a hit
+    result = cached_transform_file(cache_dir, second_input, second_output, key, CACHE_MODE_ENCRYPT, &stats, NULL);
+    assert_int_equal(result, 0);
+    assert_int_equal(stats.hits, 1);
+    assert_int_equal(stats.misses, 1);
+    assert_int_equal(stats.bytes_reused, file_size);
+    assert_int_not_equal(stats.last_method, CACHE_LINK_NONE);
+    
+    // The reused output must match a fresh encryption
+    size_t first_size, second_size;
+    char* first_content = read_test_file(first_output, &first_size);
+    char* second_content = read_test_file(second_output, &second_size);
+    
+    assert_int_equal(first_size, file_size);
+    assert_int_equal(second_size, file_size);
+    assert_memory_equal(first_content, second_content, file_size);
+    for (size_t i = 0; i < file_size; i++) {
+        assert_int_equal((uint8_t)second_content[i], encrypt_byte((uint8_t)data[i], key));
+    }
+    
+    // Cleanup
+    free(data);
+    free(first_content);
+    free(second_content);
+    unlink(first_input);
+    unlink(second_input);
+    unlink(first_output);
+    unlink(second_output);
+    remove_cache_dir(cache_dir);
+}
+
+// Test that the cache is keyed by key and mode as well as content
+static void test_dedup_cache_key_and_mode(void **state) {
+    (void)state;
+    
+    const char* cache_dir = "test_dedup_cache_keys";
+    const char* input_file = "test_dedup_keys.txt";
+    const char* output_file = "test_dedup_keys_output.bin";
+    const char* test_content = "Same content, different key and mode";
+    
+    create_test_file(input_file, test_content, strlen(test_content));
+    
+    dedup_stats stats = {0};
+    
+    assert_int_equal(cached_transform_file(cache_dir, input_file, output_file, 10, CACHE_MODE_ENCRYPT, &stats, NULL), 0);
+    assert_int_equal(cached_transform_file(cache_dir, input_file, output_file, 11, CACHE_MODE_ENCRYPT, &stats, NULL), 0);
+    assert_int_equal(cached_transform_file(cache_dir, input_file, output_file, 10, CACHE_MODE_DECRYPT, &stats, NULL), 0);
+    assert_int_equal(stats.hits, 0);
+    assert_int_equal(stats.misses, 3);
+    
+    // Normalized keys share entries (266 % 256 == 10)
+    assert_int_equal(cached_transform_file(cache_dir, input_file, output_file, 266, CACHE_MODE_ENCRYPT, &stats, NULL), 0);
+    assert_int_equal(stats.hits, 1);
+    
+    size_t output_size;
+    char* output_content = read_test_file(output_file, &output_size);
+    assert_int_equal(output_size, strlen(test_content));
+    for (size_t i = 0; i < output_size; i++) {
+        assert_int_equal((uint8_t)output_content[i], encrypt_byte((uint8_t)test_content[i], 10));
+    }
+    
+    // Cleanup
+    free(output_content);
+    unlink(input_file);
+    unlink(output_file);
+    remove_cache_dir(cache_dir);
+}
+
+// Test that overwriting an output without the cache never alters cache entries
+static void test_dedup_cache_output_overwrite(void **state) {
+    (void)state;
+    
+    const char* cache_dir = "test_dedup_cache_overwrite";
+    const char* first_input = "test_dedup_overwrite_a.txt";
+    const char* second_input = "test_dedup_overwrite_b.txt";
+    const char* output_file = "test_dedup_overwrite_out.bin";
+    const char* reused_file = "test_dedup_overwrite_out2.bin";
+    const char* first_content = "Content cached under key 42";
+    const char* second_content = "Other data written with key 7";
+    size_t first_length = strlen(first_content);
+    
+    remove_cache_dir(cache_dir);
+    create_test_file(first_input, first_content, first_length);
+    create_test_file(second_input, second_content, strlen(second_content));
+    
+    dedup_stats stats = {0};
+    
+    // Populate the cache, then overwrite the same output path without it
+    assert_int_equal(cached_transform_file(cache_dir, first_input, output_file, 42, CACHE_MODE_ENCRYPT, &stats, NULL), 0);
+    assert_int_equal(encrypt_file(second_input, output_file, 7), 0);
+    
+    // The hit must still hold the first input's ciphertext
+    assert_int_equal(cached_transform_file(cache_dir, first_input, reused_file, 42, CACHE_MODE_ENCRYPT, &stats, NULL), 0);
+    assert_int_equal(stats.hits, 1);
+    
+    size_t reused_size;
+    char* reused_content = read_test_file(reused_file, &reused_size);
+    assert_int_equal(reused_size, first_length);
+    for (size_t i = 0; i < reused_size; i++) {
+        assert_int_equal(decrypt_byte((uint8_t)reused_content[i], 42), (uint8_t)first_content[i]);
+    }
+    
+#ifdef __linux__
+    // FIFO outputs bypass the cache and are written through, not replaced
+    const char* fifo_output = "test_dedup_overwrite_fifo";
+    unlink(fifo_output);
+    assert_int_equal(mkfifo(fifo_output, 0600), 0);
+    int reader = open(fifo_output, O_RDWR | O_NONBLOCK);
+    assert_true(reader >= 0);
+    
+    dedup_stats before = stats;
+    assert_int_equal(cached_transform_file(cache_dir, first_input, fifo_output, 42, CACHE_MODE_ENCRYPT, &stats, NULL), 0);
+    assert_int_equal(stats.hits, before.hits);
+    assert_int_equal(stats.misses, before.misses);
+    
+    struct stat fifo_stat;
+    assert_int_equal(lstat(fifo_output, &fifo_stat), 0);
+    assert_true(S_ISFIFO(fifo_stat.st_mode));
+    
+    char piped[64];
+    assert_int_equal(read(reader, piped, sizeof(piped)), (ssize_t)first_length);
+    assert_memory_equal(piped, reused_content, first_length);
+    close(reader);
+    unlink(fifo_output);
+#endif
+    
+    // Published entries are read-only
+    char size_dir[256];
+    snprintf(size_dir, sizeof(size_dir), "%s/%zu", cache_dir, first_length);
+    DIR* dir = opendir(size_dir);
+    assert_non_null(dir);
+    
+    size_t entries = 0;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+            continue;
+        }
+        char path[512];
+        struct stat entry_stat;
+        snprintf(path, sizeof(path), "%s/%s", size_dir, entry->d_name);
+        assert_int_equal(stat(path, &entry_stat), 0);
+        assert_int_equal(entry_stat.st_mode & 0222, 0);
+        entries++;
+    }
+    closedir(dir);
+    assert_int_equal(entries, 1);
+    
+    // Cleanup
+    free(reused_content);
+    unlink(first_input);
+    unlink(second_input);
+    unlink(output_file);
+    unlink(reused_file);
+    remove_cache_dir(cache_dir);
+}
+
+#ifdef __linux__
+// Helper function to wait on the completion fd until count completions arrive
+static void wait_for_completions(fe_async* ctx, fe_completion* completions, size_t count) {
+    size_t received = 0;
+    
+    while (received < count) {
+        struct pollfd pfd = { .fd = fe_async_fd(ctx), .events = POLLIN };
+        assert_int_equal(poll(&pfd, 1, 10000), 1);
+        received += fe_poll_completions(ctx, completions + received, count - received);
+    }
+}
+
+// Test async file and buffer jobs reported through the completion queue
+static void test_async_file_and_buffer_jobs(void **state) {
+    (void)state;
+    
+    const char* input_file = "test_async_input.bin";
+    const char* encrypted_file = "test_async_encrypted.bin";
+    int key = 99;
+    size_t file_size = 300000; // Spans several worker chunks
+    
+    char* data = malloc(file_size);
+    assert_non_null(data);
+    for (size_t i = 0; i < file_size; i++) {
+        data[i] = (char)((i * 31) % 256);
+    }
+    create_test_file(input_file, data, file_size);
+    
+    uint8_t buffer[1000];
+    for (size_t i = 0; i < sizeof(buffer); i++) {
+        buffer[i] = (uint8_t)i;
+    }
+    
+    fe_async* ctx = fe_async_create(2);
+    assert_non_null(ctx);
+    
+    int file_tag = 1;
+    int buffer_tag = 2;
+    fe_job_id file_job = fe_submit_file(ctx, FE_JOB_ENCRYPT, input_file, encrypted_file, key, &file_tag);
+    fe_job_id buffer_job = fe_submit_buffer(ctx, FE_JOB_DECRYPT, buffer, sizeof(buffer), key, &buffer_tag);
+    assert_int_not_equal(file_job, 0);
+    assert_int_not_equal(buffer_job, 0);
+    
+    fe_completion completions[2];
+    wait_for_completions(ctx, completions, 2);
+    
+    for (size_t c = 0; c < 2; c++) {
+        assert_int_equal(completions[c].status, FE_JOB_OK);
+        if (completions[c].id == file_job) {
+            assert_true(completions[c].user_data == &file_tag);
+            assert_int_equal(completions[c].bytes_processed, file_size);
+        } else {
+            assert_int_equal(completions[c].id, buffer_job);
+            assert_true(completions[c].user_data == &buffer_tag);
+            assert_int_equal(completions[c].bytes_processed, sizeof(buffer));
+        }
+    }
+    
+    // Finished jobs are no longer tracked
+    assert_int_equal(fe_job_progress(ctx, file_job, NULL, NULL), -1);
+    assert_int_equal(fe_poll_completions(ctx, completions, 2), 0);
+    
+    for (size_t i = 0; i < sizeof(buffer); i++) {
+        assert_int_equal(buffer[i], decrypt_byte((uint8_t)i, key));
+    }
+    
+    size_t encrypted_size;
+    char* encrypted_content = read_test_file(encrypted_file, &encrypted_size);
+    assert_int_equal(encrypted_size, file_size);
+    for (size_t i = 0; i < file_size; i++) {
+        assert_int_equal((uint8_t)encrypted_content[i], encrypt_byte((uint8_t)data[i], key));
+    }
+    
+    // Cleanup
+    fe_async_destroy(ctx);
+    free(data);
+    free(encrypted_content);
+    unlink(input_file);
+    unlink(encrypted_file);
+}
+
+// Test cancellation of queued jobs and failure reporting
+static void test_async_cancel_and_errors(void **state) {
+    (void)state;
+    
+    size_t large_size = 64 * 1024 * 1024;
+    uint8_t* large = calloc(large_size, 1);
+    assert_non_null(large);
+    uint8_t small[16] = {0};
+    
+    // A single worker keeps later jobs queued behind the large one
+    fe_async* ctx = fe_async_create(1);
+    assert_non_null(ctx);
+    
+    fe_job_id running_job = fe_submit_buffer(ctx, FE_JOB_ENCRYPT, large, large_size, 1, NULL);
+    fe_job_id queued_job = fe_submit_buffer(ctx, FE_JOB_ENCRYPT, small, sizeof(small), 1, NULL);
+    fe_job_id missing_job = fe_submit_file(ctx, FE_JOB_ENCRYPT, "nonexistent_async.bin", "test_async_never.bin", 1, NULL);
+    assert_int_not_equal(running_job, 0);
+    assert_int_not_equal(queued_job, 0);
+    assert_int_not_equal(missing_job, 0);
+    
+    uint64_t done, total;
+    assert_int_equal(fe_job_progress(ctx, queued_job, &done, &total), 0);
+    assert_int_equal(done, 0);
+    assert_int_equal(total, sizeof(small));
+    
+    assert_int_equal(fe_cancel(ctx, queued_job), 0);
+    assert_int_equal(fe_cancel(ctx, 12345), -1);
+    
+    fe_completion completions[3];
+    wait_for_completions(ctx, completions, 3);
+    
+    for (size_t c = 0; c < 3; c++) {
+        if (completions[c].id == queued_job) {
+            assert_int_equal(completions[c].status, FE_JOB_CANCELLED);
+            assert_int_equal(completions[c].bytes_processed, 0);
+        } else if (completions[c].id == missing_job) {
+            assert_int_equal(completions[c].status, FE_JOB_FAILED);
+            assert_int_equal(completions[c].error, ENOENT);
+        } else {
+            assert_int_equal(completions[c].id, running_job);
+            assert_int_equal(completions[c].status, FE_JOB_OK);
+            assert_int_equal(completions[c].bytes_processed, large_size);
+        }
+    }
+    
+    // The cancelled job never touched its buffer
+    for (size_t i = 0; i < sizeof(small); i++) {
+        assert_int_equal(small[i], 0);
+    }
+    
+    // Invalid submissions are rejected up front
+    assert_int_equal(fe_submit_file(ctx, FE_JOB_ENCRYPT, NULL, "out.bin", 1, NULL), 0);
+    assert_int_equal(fe_submit_buffer(ctx, FE_JOB_ENCRYPT, NULL, 10, 1, NULL), 0);
+    
+    // Cleanup
+    fe_async_destroy(ctx);
+    free(large);
+}
+
+// Test cancelling a running file job and looking up many pending jobs
+static void test_async_cancel_running_job(void **state) {
+    (void)state;
+    
+    const char* fifo_path = "test_async_fifo";
+    const char* output_file = "test_async_cancelled.bin";
+    size_t job_count = 1000;
+    
+    unlink(fifo_path);
+    assert_int_equal(mkfifo(fifo_path, 0600), 0);
+    
+    // A single worker: the file job blocks on the FIFO, buffer jobs queue behind it
+    fe_async* ctx = fe_async_create(1);
+    assert_non_null(ctx);
+    
+    fe_job_id file_job = fe_submit_file(ctx, FE_JOB_ENCRYPT, fifo_path, output_file, 1, NULL);
+    assert_int_not_equal(file_job, 0);
+    
+    uint8_t* buffers = calloc(job_count, 16);
+    fe_job_id* ids = calloc(job_count, sizeof(*ids));
+    assert_non_null(buffers);
+    assert_non_null(ids);
+    for (size_t j = 0; j < job_count; j++) {
+        ids[j] = fe_submit_buffer(ctx, FE_JOB_ENCRYPT, buffers + j * 16, 16, 1, (void*)(uintptr_t)j);
+        assert_int_not_equal(ids[j], 0);
+    }
+    
+    // Opening the write end returns once the worker has opened the FIFO
+    int writer = open(fifo_path, O_WRONLY);
+    assert_true(writer >= 0);
+    
+    uint8_t chunk[4096];
+    memset(chunk, 'x', sizeof(chunk));
+    assert_int_equal(write(writer, chunk, sizeof(chunk)), (ssize_t)sizeof(chunk));
+    
+    uint64_t done = 0;
+    for (int tries = 0; done < sizeof(chunk) && tries < 10000; tries++) {
+        assert_int_equal(fe_job_progress(ctx, file_job, &done, NULL), 0);
+        usleep(1000);
+    }
+    assert_int_equal(done, sizeof(chunk));
+    
+    // Every pending job is found by id; cancel every other one
+    for (size_t j = 0; j < job_count; j++) {
+        uint64_t total;
+        assert_int_equal(fe_job_progress(ctx, ids[j], NULL, &total), 0);
+        assert_int_equal(total, 16);
+        if (j % 2 == 0) {
+            assert_int_equal(fe_cancel(ctx, ids[j]), 0);
+        }
+    }
+    
+    // The running job sees the flag after its next chunk and stops
+    assert_int_equal(fe_cancel(ctx, file_job), 0);
+    assert_int_equal(write(writer, chunk, sizeof(chunk)), (ssize_t)sizeof(chunk));
+    close(writer);
+    
+    fe_completion* completions = calloc(job_count + 1, sizeof(*completions));
+    assert_non_null(completions);
+    wait_for_completions(ctx, completions, job_count + 1);
+    
+    for (size_t c = 0; c <= job_count; c++) {
+        if (completions[c].id == file_job) {
+            assert_int_equal(completions[c].status, FE_JOB_CANCELLED);
+            assert_true(completions[c].bytes_processed >= sizeof(chunk));
+        } else {
+            size_t j = (size_t)(uintptr_t)completions[c].user_data;
+            assert_int_equal(completions[c].id, ids[j]);
+            assert_int_equal(completions[c].status, (j % 2 == 0) ? FE_JOB_CANCELLED : FE_JOB_OK);
+        }
+    }
+    
+    // The partial output was removed and completed jobs are forgotten
+    assert_int_equal(access(output_file, F_OK), -1);
+    assert_int_equal(fe_job_progress(ctx, file_job, NULL, NULL), -1);
+    assert_int_equal(fe_cancel(ctx, ids[1]), -1);
+    
+    // Cleanup
+    fe_async_destroy(ctx);
+    free(completions);
+    free(ids);
+    free(buffers);
+    unlink(fifo_path);
+}
+
+// Test the tuned engine across backends, block sizes and thread counts
+static void test_engine_parameter_matrix(void **state) {
+    (void)state;
+    
+    const char* input_file = "test_engine_input.bin";
+    const char* encrypted_file = "test_engine_encrypted.bin";
+    const char* decrypted_file = "test_engine_decrypted.bin";
+    int key = 123;
+    size_t file_size = 1000003; // Not a multiple of any block size
+    
+    char* data = malloc(file_size);
+    assert_non_null(data);
+    for (size_t i = 0; i < file_size; i++) {
+        data[i] = (char)((i * 13 + (i >> 9)) % 256);
+    }
+    create_test_file(input_file, data, file_size);
+    
+    size_t block_sizes[] = {ENGINE_ALIGNMENT, 64 * 1024, 1024 * 1024};
+    unsigned int thread_counts[] = {1, 3, 8};
+    
+    for (int backend = 0; backend < ENGINE_BACKEND_COUNT; backend++) {
+        for (size_t b = 0; b < sizeof(block_sizes) / sizeof(block_sizes[0]); b++) {
+            for (size_t t = 0; t < sizeof(thread_counts) / sizeof(thread_counts[0]); t++) {
+                engine_params params = {(engine_backend)backend, block_sizes[b], thread_counts[t]};
+                uint64_t processed = 0;
+                
+                int result = engine_transform_file(input_file, encrypted_file, key, ENGINE_ENCRYPT, &params, &processed, NULL);
+                if (result != 0 && backend == ENGINE_BACKEND_DIRECT && errno == EINVAL) {
+                    continue; // Filesystem without O_DIRECT support
+                }
+                assert_int_equal(result, 0);
+                assert_int_equal(processed, file_size);
+                
+                assert_int_equal(engine_transform_file(encrypted_file, decrypted_file, key, ENGINE_DECRYPT, &params, NULL, NULL), 0);
+                
+                size_t encrypted_size, decrypted_size;
+                char* encrypted_content = read_test_file(encrypted_file, &encrypted_size);
+                char* decrypted_content = read_test_file(decrypted_file, &decrypted_size);
+                
+                assert_int_equal(encrypted_size, file_size);
+                assert_int_equal(decrypted_size, file_size);
+                for (size_t i = 0; i < file_size; i++) {
+                    assert_int_equal((uint8_t)encrypted_content[i], encrypt_byte((uint8_t)data[i], key));
+                }
+                assert_memory_equal(decrypted_content, data, file_size);
+                
+                free(encrypted_content);
+                free(decrypted_content);
+            }
+        }
+    }
+    
+    // Invalid parameters are rejected
+    engine_params unaligned = {ENGINE_BACKEND_READWRITE, 1000, 1};
+    assert_int_equal(engine_transform_file(input_file, encrypted_file, key, ENGINE_ENCRYPT, &unaligned, NULL, NULL), -1);
+    assert_int_equal(engine_transform_file(input_file, encrypted_file, key, ENGINE_ENCRYPT, NULL, NULL, NULL), -1);
+    
+    // Cleanup
+    free(data);
+    unlink(input_file);
+    unlink(encrypted_file);
+    unlink(decrypted_file);
+}
+
+// Test that pipes and devices are refused by the engine but still stream through stdio
+static void test_engine_rejects_pipes(void **state) {
+    (void)state;
+    
+    const char* output_file = "test_engine_pipe_output.bin";
+    const char* data = "hello pipe data";
+    size_t length = strlen(data);
+    int key = 42;
+    
+    // An existing output must survive the rejected call
+    create_test_file(output_file, "keep", 4);
+    
+    int fds[2];
+    assert_int_equal(pipe(fds), 0);
+    assert_int_equal(write(fds[1], data, length), (ssize_t)length);
+    close(fds[1]);
+    
+    char pipe_path[64];
+    snprintf(pipe_path, sizeof(pipe_path), "/dev/fd/%d", fds[0]);
+    
+    engine_params params = {ENGINE_BACKEND_READWRITE, 64 * 1024, 2};
+    errno = 0;
+    assert_int_equal(engine_transform_file(pipe_path, output_file, key, ENGINE_ENCRYPT, &params, NULL, NULL), -1);
+    assert_int_equal(errno, ESPIPE);
+    
+    size_t output_size;
+    char* output = read_test_file(output_file, &output_size);
+    assert_int_equal(output_size, 4);
+    assert_memory_equal(output, "keep", 4);
+    free(output);
+    
+    // FIFO and device outputs are refused and never removed
+    const char* fifo_output = "test_engine_pipe_fifo";
+    unlink(fifo_output);
+    assert_int_equal(mkfifo(fifo_output, 0600), 0);
+    
+    errno = 0;
+    assert_int_equal(engine_transform_file(output_file, fifo_output, key, ENGINE_ENCRYPT, &params, NULL, NULL), -1);
+    assert_int_equal(errno, ESPIPE);
+    
+    struct stat fifo_stat;
+    assert_int_equal(lstat(fifo_output, &fifo_stat), 0);
+    assert_true(S_ISFIFO(fifo_stat.st_mode));
+    unlink(fifo_output);
+    
+    errno = 0;
+    assert_int_equal(engine_transform_file(output_file, "/dev/null", key, ENGINE_ENCRYPT, &params, NULL, NULL), -1);
+    assert_int_equal(errno, ESPIPE);
+    assert_int_equal(access("/dev/null", F_OK), 0);
+    
+    // The stdio path the CLI falls back to reads the whole stream
+    assert_int_equal(encrypt_file(pipe_path, output_file, key), 0);
+    close(fds[0]);
+    
+    output = read_test_file(output_file, &output_size);
+    assert_int_equal(output_size, length);
+    for (size_t i = 0; i < length; i++) {
+        assert_int_equal((uint8_t)output[i], encrypt_byte((uint8_t)data[i], key));
+    }
+    
+    // Cleanup
+    free(output);
+    unlink(output_file);
+}
+
+// Test that tuning profiles round-trip and stay keyed per device
+static void test_autotune_profile_roundtrip(void **state) {
+    (void)state;
+    
+    const char* profile_file = "test_tune_profile";
+    setenv("FE_TUNE_PROFILE", profile_file, 1);
+    unlink(profile_file);
+    
+    tune_profile first = {{ENGINE_BACKEND_MMAP, 1024 * 1024, 4}, 812.5};
+    tune_profile second = {{ENGINE_BACKEND_DIRECT, 64 * 1024, 2}, 300.0};
+    tune_profile updated = {{ENGINE_BACKEND_READWRITE, 256 * 1024, 1}, 150.0};
+    tune_profile loaded;
+    
+    assert_int_equal(autotune_load(1, &loaded), -1);
+    assert_int_equal(autotune_save(1, &first), 0);
+    assert_int_equal(autotune_save(2, &second), 0);
+    assert_int_equal(autotune_save(1, &updated), 0);
+    
+    assert_int_equal(autotune_load(1, &loaded), 0);
+    assert_int_equal(loaded.params.backend, ENGINE_BACKEND_READWRITE);
+    assert_int_equal(loaded.params.block_size, 256 * 1024);
+    assert_int_equal(loaded.params.threads, 1);
+    
+    assert_int_equal(autotune_load(2, &loaded), 0);
+    assert_int_equal(loaded.params.backend, ENGINE_BACKEND_DIRECT);
+    assert_int_equal(loaded.params.block_size, 64 * 1024);
+    assert_int_equal(loaded.params.threads, 2);
+    
+    assert_int_equal(autotune_load(3, &loaded), -1);
+    
+    // Calibration picks a working configuration in the current directory
+    char probe_dir[256];
+    dev_t device;
+    assert_int_equal(autotune_target("test_tune_output.bin", probe_dir, sizeof(probe_dir), &device), 0);
+    assert_string_equal(probe_dir, ".");
+    assert_int_equal(autotune_calibrate(probe_dir, &loaded), 0);
+    assert_true(loaded.mbps > 0);
+    assert_true(loaded.params.threads >= 1);
+    
+    // Cleanup
+    unlink(profile_file);
+    unsetenv("FE_TUNE_PROFILE");
+}
+
+// Test progress counters and the JSON reporter
+static void test_progress_reporting(void **state) {
+    (void)state;
+    
+    const char* input_file = "test_progress_input.bin";
+    const char* encrypted_file = "test_progress_encrypted.bin";
+    const char* decrypted_file = "test_progress_decrypted.bin";
+    const char* json_file = "test_progress.jsonl";
+    size_t file_size = 3 * FE_PROGRESS_STRIDE + 17; // Ends between publishes
+    
+    char* data = malloc(file_size);
+    assert_non_null(data);
+    for (size_t i = 0; i < file_size; i++) {
+        data[i] = (char)(i * 7);
+    }
+    create_test_file(input_file, data, file_size);
+    
+    // Every path reports the full size once it finishes
+    fe_progress progress = {0};
+    assert_int_equal(encrypt_file_with_progress(input_file, encrypted_file, 42, &progress), 0);
+    assert_int_equal(atomic_load(&progress.bytes_done), file_size);
+    
+    atomic_store(&progress.bytes_done, 0);
+    assert_int_equal(decrypt_file_with_progress(encrypted_file, decrypted_file, 42, &progress), 0);
+    assert_int_equal(atomic_load(&progress.bytes_done), file_size);
+    
+    engine_params params = {ENGINE_BACKEND_READWRITE, ENGINE_ALIGNMENT, 4};
+    atomic_store(&progress.bytes_done, 0);
+    assert_int_equal(engine_transform_file(input_file, encrypted_file, 42, ENGINE_ENCRYPT, &params, NULL, &progress), 0);
+    assert_int_equal(atomic_load(&progress.bytes_done), file_size);
+    
+    // The reporter ends with a final JSON line at 100%
+    unlink(json_file);
+    int json_fd = open(json_file, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    assert_true(json_fd >= 0);
+    
+    atomic_store(&progress.bytes_done, 0);
+    progress_reporter* reporter = progress_reporter_start(&progress, file_size, NULL, json_fd, 10);
+    assert_non_null(reporter);
+    assert_int_equal(encrypt_file_with_progress(input_file, encrypted_file, 42, &progress), 0);
+    usleep(30 * 1000);
+    progress_reporter_stop(reporter);
+    close(json_fd);
+    
+    size_t json_size;
+    char* json = read_test_file(json_file, &json_size);
+    assert_non_null(json);
+    assert_true(json_size > 0 && json[json_size - 1] == '\n');
+    
+    json[json_size - 1] = '\0';
+    char* last_line = strrchr(json, '\n');
+    last_line = last_line ? last_line + 1 : json;
+    assert_non_null(strstr(last_line, "\"final\":true"));
+    assert_non_null(strstr(last_line, "\"percent\":100.00"));
+    
+    // Nothing to report to
+    assert_null(progress_reporter_start(&progress, file_size, NULL, -1, 10));
+    
+    // Unknown totals (pipes) report bytes and rate but no percent or ETA
+    unlink(json_file);
+    json_fd = open(json_file, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    assert_true(json_fd >= 0);
+    FILE* human = tmpfile();
+    assert_non_null(human);
+    
+    atomic_store(&progress.bytes_done, 1000);
+    reporter = progress_reporter_start(&progress, FE_PROGRESS_TOTAL_UNKNOWN, human, json_fd, 10);
+    assert_non_null(reporter);
+    progress_reporter_stop(reporter);
+    close(json_fd);
+    
+    free(json);
+    json = read_test_file(json_file, &json_size);
+    assert_true(json_size > 0);
+    json[json_size - 1] = '\0';
+    assert_non_null(strstr(json, "\"bytes_done\":1000,\"bytes_total\":null,\"percent\":null"));
+    assert_non_null(strstr(json, "\"eta_sec\":null"));
+    
+    char human_line[256] = {0};
+    rewind(human);
+    assert_non_null(fgets(human_line, sizeof(human_line), human));
+    fclose(human);
+    assert_non_null(strstr(human_line, "Progress:    --  1000 B / --"));
+    assert_non_null(strstr(human_line, "ETA --:--:--"));
+    
+    // Cleanup
+    free(json);
+    free(data);
+    unlink(input_file);
+    unlink(encrypted_file);
+    unlink(decrypted_file);
+    unlink(json_file);
+}
+#endif
+
 int main(void) {
     const struct CMUnitTest tests[] = {
         cmocka_unit_test(test_byte_encryption_basic),
         cmocka_unit_test(test_byte_encryption_edge_cases),
         cmocka_unit_test(test_byte_encryption_negative_key),
         cmocka_unit_test(test_byte_encryption_large_key),
+        cmocka_unit_test(test_buffer_encryption_matches_bytes),
         cmocka_unit_test(test_text_file_encryption),
         cmocka_unit_test(test_binary_file_encryption),
         cmocka_unit_test(test_empty_file_encryption),
@@ -489,6 +1291,19 @@ int main(void) {
         cmocka_unit_test(test_video_like_file_encryption),   
         cmocka_unit_test(test_invalid_input_file),
         cmocka_unit_test(test_null_parameters),
+        cmocka_unit_test(test_dedup_hash_vectors),
+        cmocka_unit_test(test_dedup_cache_hit),
+        cmocka_unit_test(test_dedup_cache_key_and_mode),
+        cmocka_unit_test(test_dedup_cache_output_overwrite),
+#ifdef __linux__
+        cmocka_unit_test(test_async_file_and_buffer_jobs),
+        cmocka_unit_test(test_async_cancel_and_errors),
+        cmocka_unit_test(test_async_cancel_running_job),
+        cmocka_unit_test(test_engine_parameter_matrix),
+        cmocka_unit_test(test_engine_rejects_pipes),
+        cmocka_unit_test(test_autotune_profile_roundtrip),
+        cmocka_unit_test(test_progress_reporting),
+#endif
     };
     
     return cmocka_run_group_tests(tests, NULL, NULL);
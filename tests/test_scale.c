@@ -0,0 +1,560 @@
+#define _GNU_SOURCE // memfd_create
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "encryption.h"
+#include "decryption.h"
+#include "async_jobs.h"
+#include "engine.h"
+
+// Scale and throughput tests.
+//
+// Input data is a deterministic function of the byte offset, so streams of
+// any size can be generated and verified chunk by chunk without keeping a
+// copy. Data lives in memfds (or sparse temp files) rather than on disk.
+//
+// Environment:
+//   FE_SCALE_MB          Stream size per engine in MiB (default 32)
+//   FE_SCALE_REPORT      Append throughput results as CSV to this file
+//   FE_SCALE_MIN_SPEEDUP Fail if the widest worker pool is not this much
+//                        faster than one worker (e.g. 1.5)
+//   FE_SCALE_LARGE       Set to 1 to round-trip a sparse file past 4 GiB
+//                        (needs ~8 GiB of free space in TMPDIR)
+
+#define SCALE_SEED 0x5eed5eed5eed5eedULL
+#define SCALE_CHUNK (1024 * 1024)
+#define SCALE_MAX_PARTS 8
+
+static const unsigned int worker_counts[] = {1, 2, 4, 8};
+
+// splitmix64 finalizer
+static uint64_t mix64(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+static uint8_t synth_byte(uint64_t offset) {
+    return (uint8_t)(mix64(SCALE_SEED ^ (offset >> 3)) >> ((offset & 7) * 8));
+}
+
+static void synth_fill(uint8_t* buffer, size_t length, uint64_t offset) {
+    for (size_t i = 0; i < length; i++) {
+        buffer[i] = synth_byte(offset + i);
+    }
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static uint64_t scale_bytes(void) {
+    const char* value = getenv("FE_SCALE_MB");
+    unsigned long long mb = value ? strtoull(value, NULL, 10) : 32;
+    return (uint64_t)(mb ? mb : 32) * 1024 * 1024;
+}
+
+static void fd_path(char* path, size_t size, int fd) {
+    snprintf(path, size, "/proc/self/fd/%d", fd);
+}
+
+// Helper function to record a throughput sample
+static double record_throughput(const char* engine, unsigned int threads, uint64_t bytes, double seconds) {
+    double mbps = seconds > 0 ? (double)bytes / (1024.0 * 1024.0) / seconds : 0.0;
+    printf("  %-14s threads=%u  %10.1f MB/s  (%llu bytes, %.3f s)\n",
+           engine, threads, mbps, (unsigned long long)bytes, seconds);
+
+    const char* report = getenv("FE_SCALE_REPORT");
+    if (report && *report) {
+        FILE* file = fopen(report, "a");
+        if (file) {
+            fprintf(file, "%s,%u,%llu,%.6f,%.1f\n", engine, threads, (unsigned long long)bytes, seconds, mbps);
+            fclose(file);
+        }
+    }
+    return mbps;
+}
+
+static void check_speedup(const char* engine, double single, double widest) {
+    const char* value = getenv("FE_SCALE_MIN_SPEEDUP");
+    if (!value || !*value || single <= 0) {
+        return;
+    }
+
+    double required = strtod(value, NULL);
+    printf("  %s speedup: %.2fx (required %.2fx)\n", engine, widest / single, required);
+    assert_true(widest >= single * required);
+}
+
+// Helper function to create a memfd holding synthetic data for [offset, offset + size)
+static int synth_memfd(uint64_t offset, uint64_t size) {
+    int fd = memfd_create("fe_scale_input", MFD_CLOEXEC);
+    assert_true(fd >= 0);
+
+    uint8_t* buffer = malloc(SCALE_CHUNK);
+    assert_non_null(buffer);
+
+    for (uint64_t done = 0; done < size;) {
+        size_t n = (size - done) < SCALE_CHUNK ? (size_t)(size - done) : SCALE_CHUNK;
+        synth_fill(buffer, n, offset + done);
+        assert_int_equal(pwrite(fd, buffer, n, (off_t)done), (ssize_t)n);
+        done += n;
+    }
+
+    free(buffer);
+    return fd;
+}
+
+static int empty_memfd(void) {
+    int fd = memfd_create("fe_scale_output", MFD_CLOEXEC);
+    assert_true(fd >= 0);
+    return fd;
+}
+
+// Compare fd contents against the scalar reference applied to the synthetic
+// stream. Sparse regions outside [data_start, data_end) are expected to be zero.
+static void verify_fd(int fd, uint64_t offset, uint64_t size, int key, int encrypted,
+                      uint64_t data_start, uint64_t data_end) {
+    struct stat st;
+    assert_int_equal(fstat(fd, &st), 0);
+    assert_int_equal((uint64_t)st.st_size, size);
+
+    uint8_t* buffer = malloc(SCALE_CHUNK);
+    assert_non_null(buffer);
+
+    for (uint64_t done = 0; done < size;) {
+        size_t n = (size - done) < SCALE_CHUNK ? (size_t)(size - done) : SCALE_CHUNK;
+        assert_int_equal(pread(fd, buffer, n, (off_t)done), (ssize_t)n);
+
+        for (size_t i = 0; i < n; i++) {
+            uint64_t position = offset + done + i;
+            uint8_t plain = (position >= data_start && position < data_end) ? synth_byte(position) : 0;
+            uint8_t expected = encrypted ? encrypt_byte(plain, key) : plain;
+            if (buffer[i] != expected) {
+                fprintf(stderr, "Mismatch at offset %llu: got %u, expected %u\n",
+                        (unsigned long long)(done + i), buffer[i], expected);
+                free(buffer);
+                fail();
+            }
+        }
+        done += n;
+    }
+
+    free(buffer);
+}
+
+static void wait_for_completions(fe_async* ctx, fe_completion* completions, size_t count) {
+    size_t received = 0;
+
+    while (received < count) {
+        struct pollfd pfd = { .fd = fe_async_fd(ctx), .events = POLLIN };
+        assert_int_equal(poll(&pfd, 1, 600000), 1);
+        received += fe_poll_completions(ctx, completions + received, count - received);
+    }
+}
+
+// Test the stdio engine (encrypt_file/decrypt_file) on a memfd-backed stream
+static void test_scale_stdio_engine(void **state) {
+    (void)state;
+
+    uint64_t size = scale_bytes();
+    int key = 173;
+    char input_path[64], encrypted_path[64], decrypted_path[64];
+
+    int input_fd = synth_memfd(0, size);
+    int encrypted_fd = empty_memfd();
+    int decrypted_fd = empty_memfd();
+    fd_path(input_path, sizeof(input_path), input_fd);
+    fd_path(encrypted_path, sizeof(encrypted_path), encrypted_fd);
+    fd_path(decrypted_path, sizeof(decrypted_path), decrypted_fd);
+
+    double start = now_seconds();
+    assert_int_equal(encrypt_file(input_path, encrypted_path, key), 0);
+    record_throughput("stdio-encrypt", 1, size, now_seconds() - start);
+
+    start = now_seconds();
+    assert_int_equal(decrypt_file(encrypted_path, decrypted_path, key), 0);
+    record_throughput("stdio-decrypt", 1, size, now_seconds() - start);
+
+    verify_fd(encrypted_fd, 0, size, key, 1, 0, size);
+    verify_fd(decrypted_fd, 0, size, key, 0, 0, size);
+
+    // Cleanup
+    close(input_fd);
+    close(encrypted_fd);
+    close(decrypted_fd);
+}
+
+// Test the buffer kernels and async buffer jobs across worker counts
+static void test_scale_buffer_engines(void **state) {
+    (void)state;
+
+    uint64_t size = scale_bytes();
+    int key = -77;
+
+    uint8_t* data = malloc(size);
+    assert_non_null(data);
+    synth_fill(data, size, 0);
+
+    // Single-threaded kernel, in place
+    double start = now_seconds();
+    encrypt_buffer(data, size, key);
+    record_throughput("buffer-encrypt", 1, size, now_seconds() - start);
+
+    for (uint64_t i = 0; i < size; i++) {
+        assert_int_equal(data[i], encrypt_byte(synth_byte(i), key));
+    }
+
+    start = now_seconds();
+    decrypt_buffer(data, size, key);
+    record_throughput("buffer-decrypt", 1, size, now_seconds() - start);
+
+    // Worker pools: one slice per worker, encrypt then decrypt
+    double single = 0.0;
+    double widest = 0.0;
+    for (size_t w = 0; w < sizeof(worker_counts) / sizeof(worker_counts[0]); w++) {
+        unsigned int workers = worker_counts[w];
+        fe_async* ctx = fe_async_create(workers);
+        assert_non_null(ctx);
+
+        fe_job_op ops[2] = {FE_JOB_ENCRYPT, FE_JOB_DECRYPT};
+        for (int pass = 0; pass < 2; pass++) {
+            uint64_t slice = (size + workers - 1) / workers;
+
+            start = now_seconds();
+            size_t submitted = 0;
+            for (uint64_t offset = 0; offset < size; offset += slice) {
+                uint64_t length = (size - offset) < slice ? (size - offset) : slice;
+                assert_int_not_equal(fe_submit_buffer(ctx, ops[pass], data + offset, length, key, NULL), 0);
+                submitted++;
+            }
+
+            fe_completion completions[SCALE_MAX_PARTS];
+            wait_for_completions(ctx, completions, submitted);
+            double mbps = record_throughput(pass == 0 ? "async-buf-enc" : "async-buf-dec",
+                                            workers, size, now_seconds() - start);
+
+            for (size_t c = 0; c < submitted; c++) {
+                assert_int_equal(completions[c].status, FE_JOB_OK);
+            }
+            if (pass == 0) {
+                if (workers == 1) {
+                    single = mbps;
+                }
+                widest = mbps;
+            }
+        }
+
+        fe_async_destroy(ctx);
+    }
+
+    // The round trips must restore the original stream
+    for (uint64_t i = 0; i < size; i++) {
+        assert_int_equal(data[i], synth_byte(i));
+    }
+    check_speedup("async-buffer", single, widest);
+
+    free(data);
+}
+
+// Test async file jobs across worker counts, one memfd part per worker
+static void test_scale_async_file_engine(void **state) {
+    (void)state;
+
+    uint64_t size = scale_bytes();
+    int key = 1000;
+    double single = 0.0;
+    double widest = 0.0;
+
+    for (size_t w = 0; w < sizeof(worker_counts) / sizeof(worker_counts[0]); w++) {
+        unsigned int parts = worker_counts[w];
+        uint64_t part_size = size / parts;
+
+        int input_fds[SCALE_MAX_PARTS], output_fds[SCALE_MAX_PARTS], decrypted_fds[SCALE_MAX_PARTS];
+        for (unsigned int p = 0; p < parts; p++) {
+            input_fds[p] = synth_memfd(p * part_size, part_size);
+            output_fds[p] = empty_memfd();
+            decrypted_fds[p] = empty_memfd();
+        }
+
+        fe_async* ctx = fe_async_create(parts);
+        assert_non_null(ctx);
+
+        double start = now_seconds();
+        for (unsigned int p = 0; p < parts; p++) {
+            char input_path[64], output_path[64];
+            fd_path(input_path, sizeof(input_path), input_fds[p]);
+            fd_path(output_path, sizeof(output_path), output_fds[p]);
+            assert_int_not_equal(fe_submit_file(ctx, FE_JOB_ENCRYPT, input_path, output_path, key, NULL), 0);
+        }
+
+        fe_completion completions[SCALE_MAX_PARTS];
+        wait_for_completions(ctx, completions, parts);
+        double mbps = record_throughput("async-file", parts, part_size * parts, now_seconds() - start);
+        if (parts == 1) {
+            single = mbps;
+        }
+        widest = mbps;
+
+        for (unsigned int c = 0; c < parts; c++) {
+            assert_int_equal(completions[c].status, FE_JOB_OK);
+            assert_int_equal(completions[c].bytes_processed, part_size);
+        }
+
+        for (unsigned int p = 0; p < parts; p++) {
+            verify_fd(output_fds[p], p * part_size, part_size, key, 1, 0, UINT64_MAX);
+        }
+
+        // Decrypt each part back and compare against the plaintext
+        start = now_seconds();
+        for (unsigned int p = 0; p < parts; p++) {
+            char input_path[64], output_path[64];
+            fd_path(input_path, sizeof(input_path), output_fds[p]);
+            fd_path(output_path, sizeof(output_path), decrypted_fds[p]);
+            assert_int_not_equal(fe_submit_file(ctx, FE_JOB_DECRYPT, input_path, output_path, key, NULL), 0);
+        }
+
+        wait_for_completions(ctx, completions, parts);
+        record_throughput("async-file-dec", parts, part_size * parts, now_seconds() - start);
+
+        for (unsigned int c = 0; c < parts; c++) {
+            assert_int_equal(completions[c].status, FE_JOB_OK);
+            assert_int_equal(completions[c].bytes_processed, part_size);
+        }
+
+        for (unsigned int p = 0; p < parts; p++) {
+            verify_fd(decrypted_fds[p], p * part_size, part_size, key, 0, 0, UINT64_MAX);
+            close(input_fds[p]);
+            close(output_fds[p]);
+            close(decrypted_fds[p]);
+        }
+
+        fe_async_destroy(ctx);
+    }
+
+    check_speedup("async-file", single, widest);
+}
+
+// Test the tuned engine across backends and thread counts
+static void test_scale_tuned_engine(void **state) {
+    (void)state;
+
+    uint64_t size = scale_bytes();
+    int key = 58;
+    char input_path[64], output_path[64], decrypted_path[64];
+
+    int input_fd = synth_memfd(0, size);
+    int output_fd = empty_memfd();
+    int decrypted_fd = empty_memfd();
+    fd_path(input_path, sizeof(input_path), input_fd);
+    fd_path(output_path, sizeof(output_path), output_fd);
+    fd_path(decrypted_path, sizeof(decrypted_path), decrypted_fd);
+
+    for (int backend = 0; backend < ENGINE_BACKEND_COUNT; backend++) {
+        char engine[32], engine_dec[40];
+        snprintf(engine, sizeof(engine), "engine-%s", engine_backend_name((engine_backend)backend));
+        snprintf(engine_dec, sizeof(engine_dec), "%s-dec", engine);
+
+        double single = 0.0;
+        double widest = 0.0;
+        for (size_t w = 0; w < sizeof(worker_counts) / sizeof(worker_counts[0]); w++) {
+            engine_params params = {(engine_backend)backend, 1024 * 1024, worker_counts[w]};
+
+            double start = now_seconds();
+            int result = engine_transform_file(input_path, output_path, key, ENGINE_ENCRYPT, &params, NULL, NULL);
+            if (result != 0 && backend == ENGINE_BACKEND_DIRECT && errno == EINVAL) {
+                printf("  %-14s not supported on memfd\n", engine);
+                break;
+            }
+            assert_int_equal(result, 0);
+            double mbps = record_throughput(engine, worker_counts[w], size, now_seconds() - start);
+            if (w == 0) {
+                single = mbps;
+            }
+            widest = mbps;
+
+            verify_fd(output_fd, 0, size, key, 1, 0, size);
+
+            start = now_seconds();
+            assert_int_equal(engine_transform_file(output_path, decrypted_path, key, ENGINE_DECRYPT, &params, NULL, NULL), 0);
+            record_throughput(engine_dec, worker_counts[w], size, now_seconds() - start);
+
+            verify_fd(decrypted_fd, 0, size, key, 0, 0, size);
+        }
+        check_speedup(engine, single, widest);
+    }
+
+    // Cleanup
+    close(input_fd);
+    close(output_fd);
+    close(decrypted_fd);
+}
+
+// Helper function to create a sparse temp file with data only around the 4 GiB mark
+static int sparse_input(char* path, size_t path_size, uint64_t size, uint64_t data_start, uint64_t data_end) {
+    const char* tmpdir = getenv("TMPDIR");
+    snprintf(path, path_size, "%s/fe_scale_XXXXXX", (tmpdir && *tmpdir) ? tmpdir : "/tmp");
+
+    int fd = mkstemp(path);
+    assert_true(fd >= 0);
+    assert_int_equal(ftruncate(fd, (off_t)size), 0);
+
+    uint8_t* buffer = malloc(SCALE_CHUNK);
+    assert_non_null(buffer);
+    for (uint64_t offset = data_start; offset < data_end;) {
+        size_t n = (data_end - offset) < SCALE_CHUNK ? (size_t)(data_end - offset) : SCALE_CHUNK;
+        synth_fill(buffer, n, offset);
+        assert_int_equal(pwrite(fd, buffer, n, (off_t)offset), (ssize_t)n);
+        offset += n;
+    }
+    free(buffer);
+
+    return fd;
+}
+
+// Test that 64-bit sizes are reported correctly; cheap enough to always run
+static void test_scale_sparse_progress_beyond_4gib(void **state) {
+    (void)state;
+
+    uint64_t size = (5ULL << 30);
+    char input_path[256];
+    int input_fd = sparse_input(input_path, sizeof(input_path), size, size - 4096, size);
+
+    char output_path[sizeof(input_path) + 8];
+    snprintf(output_path, sizeof(output_path), "%s.out", input_path);
+
+    fe_async* ctx = fe_async_create(1);
+    assert_non_null(ctx);
+
+    fe_job_id job = fe_submit_file(ctx, FE_JOB_ENCRYPT, input_path, output_path, 5, NULL);
+    assert_int_not_equal(job, 0);
+
+    // Wait until the job is running and has sized its input
+    uint64_t done = 0, total = 0;
+    while (fe_job_progress(ctx, job, &done, &total) == 0 && done == 0) {
+        usleep(1000);
+    }
+    assert_int_equal(total, size);
+    assert_int_equal(fe_cancel(ctx, job), 0);
+
+    fe_completion completion;
+    wait_for_completions(ctx, &completion, 1);
+    assert_int_equal(completion.status, FE_JOB_CANCELLED);
+    assert_true(completion.bytes_processed > 0 && completion.bytes_processed < size);
+
+    // Cancelled jobs remove their partial output
+    assert_int_equal(access(output_path, F_OK), -1);
+
+    // Cleanup
+    fe_async_destroy(ctx);
+    close(input_fd);
+    unlink(input_path);
+}
+
+// Test full round trips across the 4 GiB boundary (opt-in, needs real disk space)
+static void test_scale_sparse_roundtrip_beyond_4gib(void **state) {
+    (void)state;
+
+    const char* enabled = getenv("FE_SCALE_LARGE");
+    if (!enabled || strcmp(enabled, "1") != 0) {
+        skip();
+    }
+
+    uint64_t size = (4ULL << 30) + (3ULL << 20);
+    uint64_t data_start = (4ULL << 30) - (1ULL << 20);
+    uint64_t data_end = (4ULL << 30) + (2ULL << 20);
+    int key = 211;
+
+    char input_path[256];
+    int input_fd = sparse_input(input_path, sizeof(input_path), size, data_start, data_end);
+
+    char output_path[sizeof(input_path) + 8];
+    char decrypted_path[sizeof(input_path) + 8];
+    snprintf(output_path, sizeof(output_path), "%s.out", input_path);
+    snprintf(decrypted_path, sizeof(decrypted_path), "%s.dec", input_path);
+
+    // Async worker
+    fe_async* ctx = fe_async_create(1);
+    assert_non_null(ctx);
+
+    double start = now_seconds();
+    assert_int_not_equal(fe_submit_file(ctx, FE_JOB_ENCRYPT, input_path, output_path, key, NULL), 0);
+
+    fe_completion completion;
+    wait_for_completions(ctx, &completion, 1);
+    record_throughput("async-file-4g", 1, size, now_seconds() - start);
+    assert_int_equal(completion.status, FE_JOB_OK);
+    assert_int_equal(completion.bytes_processed, size);
+
+    int output_fd = open(output_path, O_RDONLY | O_CLOEXEC);
+    assert_true(output_fd >= 0);
+    verify_fd(output_fd, 0, size, key, 1, data_start, data_end);
+    close(output_fd);
+
+    start = now_seconds();
+    assert_int_not_equal(fe_submit_file(ctx, FE_JOB_DECRYPT, output_path, decrypted_path, key, NULL), 0);
+    wait_for_completions(ctx, &completion, 1);
+    record_throughput("async-file-4g-dec", 1, size, now_seconds() - start);
+    assert_int_equal(completion.status, FE_JOB_OK);
+    assert_int_equal(completion.bytes_processed, size);
+    fe_async_destroy(ctx);
+
+    int decrypted_fd = open(decrypted_path, O_RDONLY | O_CLOEXEC);
+    assert_true(decrypted_fd >= 0);
+    verify_fd(decrypted_fd, 0, size, key, 0, data_start, data_end);
+    close(decrypted_fd);
+
+    // stdio engine
+    start = now_seconds();
+    assert_int_equal(encrypt_file(input_path, output_path, key), 0);
+    record_throughput("stdio-4g", 1, size, now_seconds() - start);
+
+    output_fd = open(output_path, O_RDONLY | O_CLOEXEC);
+    assert_true(output_fd >= 0);
+    verify_fd(output_fd, 0, size, key, 1, data_start, data_end);
+    close(output_fd);
+
+    start = now_seconds();
+    assert_int_equal(decrypt_file(output_path, decrypted_path, key), 0);
+    record_throughput("stdio-4g-dec", 1, size, now_seconds() - start);
+
+    decrypted_fd = open(decrypted_path, O_RDONLY | O_CLOEXEC);
+    assert_true(decrypted_fd >= 0);
+    verify_fd(decrypted_fd, 0, size, key, 0, data_start, data_end);
+    close(decrypted_fd);
+
+    // Cleanup
+    close(input_fd);
+    unlink(input_path);
+    unlink(output_path);
+    unlink(decrypted_path);
+}
+
+int main(void) {
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_scale_stdio_engine),
+        cmocka_unit_test(test_scale_buffer_engines),
+        cmocka_unit_test(test_scale_async_file_engine),
+        cmocka_unit_test(test_scale_tuned_engine),
+        cmocka_unit_test(test_scale_sparse_progress_beyond_4gib),
+        cmocka_unit_test(test_scale_sparse_roundtrip_beyond_4gib),
+    };
+
+    return cmocka_run_group_tests(tests, NULL, NULL);
+}